@@ -0,0 +1,31 @@
+#!/bin/sh
+
+# Route a testcase with several --p1-batch sizes, and report for each one the wall time,
+# the overflow after the initial routing, and the 2D overflow and wirelength at the end.
+
+if [ $# -lt 2 ]
+then
+    echo "Please use the following command"
+    echo "$0 [route] [input] [options]..."
+    echo "route is the router executable, input a .gr testcase, the options are given to every run."
+    echo "The batch sizes are taken from BATCHES (default \"0 1 16 64 256\")."
+    exit 1
+fi
+
+exeFile=$1
+caseName=$2
+shift 2
+work=$(basename $caseName).batch
+rm -rf $work
+mkdir $work
+
+echo "batch    time(ms)  initial max/total overflow    final max/total overflow  wirelength"
+for batch in ${BATCHES:-0 1 16 64 256}; do
+    start=$(date +%s%N)
+    $exeFile --input=$caseName --output=$work/$batch.res --p1-batch=$batch $* > $work/$batch.log || exit 1
+    end=$(date +%s%N)
+    initial=$(grep "cal max overflow" $work/$batch.log | head -1 | sed 's/.*overflow= \([0-9]*\) cur_cap-max_cap= \([0-9]*\).*/\1\/\2/')
+    final=$(grep "cal max overflow" $work/$batch.log | tail -1 | sed 's/.*overflow= \([0-9]*\) cur_cap-max_cap= \([0-9]*\).*/\1\/\2/')
+    wirelength=$(grep "total wire length: " $work/$batch.log | tail -1 | sed "s/.*: //")
+    printf "%5s %11d %27s %27s %11s\n" $batch $(( (end - start) / 1000000 )) $initial $final $wirelength
+done
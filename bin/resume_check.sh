@@ -0,0 +1,45 @@
+#!/bin/sh
+
+# Check that a run resumed from a checkpoint gives the output of the uninterrupted run,
+# once from the main stage and once from the refinement stage.
+
+if [ $# -lt 2 ]
+then
+    echo "Please use the following command"
+    echo "$0 [route] [input] [options]..."
+    echo "route is the router executable, input a .gr testcase, the options are given to every run."
+    exit 1
+fi
+
+exeFile=$1
+caseName=$2
+shift 2
+options="--p2-max-iteration=40 --overflow-threshold=0 --p3-max-iteration=4 $*"
+work=$(basename $caseName).resume
+rm -rf $work
+mkdir $work
+
+$exeFile --input=$caseName --output=$work/full.res $options > $work/full.log || exit 1
+
+status=0
+# the main stage checkpoint is the last one of a run without refinement,
+# the refinement stage checkpoint the last one of a complete run
+for stage in main refinement; do
+    if [ $stage = "main" ]
+    then
+        interrupted="$options --p3-max-iteration=0"
+    else
+        interrupted="$options"
+    fi
+    $exeFile --input=$caseName --output=$work/$stage.ckp.res --checkpoint=$work/$stage.ckp --checkpoint-interval=1 $interrupted > $work/$stage.ckp.log || exit 1
+    $exeFile --input=$caseName --output=$work/$stage.res --resume=$work/$stage.ckp $options > $work/$stage.log || exit 1
+    grep "resume from" $work/$stage.log
+    if cmp -s $work/full.res $work/$stage.res
+    then
+        echo "$stage stage resume: same output"
+    else
+        echo "$stage stage resume: output differs"
+        status=1
+    fi
+done
+exit $status
@@ -7,8 +7,8 @@
                     // Setting MAXD to more than 150 is not recommended
                     // jalamorm change to 350 in 12/13/2007
 
-#ifndef DTYPE   // Data type for distance
-#define DTYPE double
+#ifndef DTYPE   // Data type for distance: int for the GCell coordinates, -DDTYPE=double for real ones
+#define DTYPE int
 #endif
 
 typedef struct
@@ -2,15 +2,18 @@
 #define INC_FLUTE_FUNCTION_H
 
 #define ACCURACY 3  // Default accuracy
-#ifndef DTYPE   // Data type for distance
-#define DTYPE double
+#ifndef DTYPE   // Data type for distance: int for the GCell coordinates, -DDTYPE=double for real ones
+#define DTYPE int
 #endif
 
+struct FluteLUT;
+
 // Major functions
-extern void readLUT();
+extern const FluteLUT& readLUT();  // Loaded once per process, shared by all the threads
 extern DTYPE flute_wl(int d, DTYPE x[], DTYPE y[], int acc);
 //Macro: DTYPE flutes_wl(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 extern Tree flute(int d, DTYPE x[], DTYPE y[], int acc);
+extern Tree flute(int d, DTYPE x[], DTYPE y[], int acc, Branch *branch);  // Tree written to branch, of 2*d-2 branches
 //Macro: Tree flutes(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 extern DTYPE wirelength(Tree t);
 extern void printtree(Tree t);
@@ -20,7 +23,7 @@ extern void plottree(Tree t);
 extern DTYPE flutes_wl_LD(int d, DTYPE xs[], DTYPE ys[], int s[]);
 extern DTYPE flutes_wl_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 extern DTYPE flutes_wl_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
-extern Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[]);
+extern Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[], Branch *branch);
 extern Tree flutes_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 extern Tree flutes_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <math.h>
+#include <string.h>
 #include "flute.h"
 
 #if D<=7
@@ -14,7 +15,7 @@
 #define MGROUP 362880/4  // Max. # of groups, 9! = 362880
 #define MPOWV 79  // Max. # of POWVs per group
 #endif
-int numgrp[10] = { 0, 0, 0, 0, 6, 30, 180, 1260, 10080, 90720 };
+const int numgrp[10] = { 0, 0, 0, 0, 6, 30, 180, 1260, 10080, 90720 };
 
 struct csoln {
     unsigned char parent;
@@ -22,16 +23,22 @@ struct csoln {
     unsigned char rowcol[D - 2];  // row = rowcol[]/16, col = rowcol[]%16,
     unsigned char neighbor[2 * D - 2];
 };
-struct csoln *LUT[D + 1][MGROUP];  // storing 4 .. D
-int numsoln[D + 1][MGROUP];
+// The lookup tables, read once and never modified, so that any number of threads
+// can build trees at the same time. The scratch arrays live on the stack of each call.
+struct FluteLUT {
+    struct csoln *LUT[D + 1][MGROUP];  // storing 4 .. D
+    int numsoln[D + 1][MGROUP];
+};
 
-void readLUT();
+static FluteLUT *loadLUT();
+const FluteLUT& readLUT();
 DTYPE flute_wl(int d, DTYPE x[], DTYPE y[], int acc);
 DTYPE flutes_wl_LD(int d, DTYPE xs[], DTYPE ys[], int s[]);
 DTYPE flutes_wl_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 DTYPE flutes_wl_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 Tree flute(int d, DTYPE x[], DTYPE y[], int acc);
-Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[]);
+Tree flute(int d, DTYPE x[], DTYPE y[], int acc, Branch *branch);
+Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[], Branch *branch);
 Tree flutes_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 Tree flutes_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc);
 Tree dmergetree(Tree t1, Tree t2);
@@ -42,11 +49,18 @@ DTYPE wirelength(Tree t);
 void printtree(Tree t);
 void plottree(Tree t);
 
-void readLUT() {
+// Loaded on the first call, by a single thread; kept for the whole process
+const FluteLUT& readLUT() {
+    static const FluteLUT *lut = loadLUT();
+    return *lut;
+}
+
+static FluteLUT *loadLUT() {
     unsigned char charnum[256], line[32], *linep, c;
     FILE *fpwv, *fprt;
     struct csoln *p;
     int d, i, j, k, kk, ns, nn;
+    FluteLUT *lut = new FluteLUT;
 
     for (i = 0; i <= 255; i++) {
         if ('0' <= i && i <= '9')
@@ -82,13 +96,13 @@ void readLUT() {
 
             if (ns == 0) {  // same as some previous group
                 fscanf(fpwv, "%d\n", &kk);
-                numsoln[d][k] = numsoln[d][kk];
-                LUT[d][k] = LUT[d][kk];
+                lut->numsoln[d][k] = lut->numsoln[d][kk];
+                lut->LUT[d][k] = lut->LUT[d][kk];
             } else {
                 fgetc(fpwv);  // '\n'
-                numsoln[d][k] = ns;
+                lut->numsoln[d][k] = ns;
                 p = (struct csoln*) malloc(ns * sizeof(struct csoln));
-                LUT[d][k] = p;
+                lut->LUT[d][k] = p;
                 for (i = 1; i <= ns; i++) {
                     linep = (unsigned char *) fgets((char *) line, 32, fpwv);
                     p->parent = charnum[*(linep++)];
@@ -119,6 +133,11 @@ void readLUT() {
             }
         }
     }
+    fclose(fpwv);
+#if ROUTING==1
+    fclose(fprt);
+#endif
+    return lut;
 }
 
 DTYPE flute_wl(int d, DTYPE x[], DTYPE y[], int acc) {
@@ -247,6 +266,7 @@ DTYPE flutes_wl_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc) {
 
 // For low-degree, i.e., 2 <= d <= D
 DTYPE flutes_wl_LD(int d, DTYPE xs[], DTYPE ys[], int s[]) {
+    const FluteLUT& lut = readLUT();
     int k, pi, i, j;
     struct csoln *rlist;
     DTYPE dd[2 * D - 2];  // 0..D-2 for v, D-1..2*D-3 for h
@@ -283,13 +303,13 @@ DTYPE flutes_wl_LD(int d, DTYPE xs[], DTYPE ys[], int s[]) {
         }
 
         minl = l[0] = xs[d - 1] - xs[0] + ys[d - 1] - ys[0];
-        rlist = LUT[d][k];
+        rlist = lut.LUT[d][k];
         for (i = 0; rlist->seg[i] > 0; i++)
             minl += dd[rlist->seg[i]];
 
         l[1] = minl;
         j = 2;
-        while (j <= numsoln[d][k]) {
+        while (j <= lut.numsoln[d][k]) {
             rlist++;
             sum = l[rlist->parent];
             for (i = 0; rlist->seg[i] > 0; i++)
@@ -433,15 +453,15 @@ DTYPE flutes_wl_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc) {
     nbp = 0;
     for (r = lb; r <= ub; r++) {
         if (si[r] == 0 || si[r] == d - 1)
-            score[nbp] = (xs[r + 1] - xs[r - 1]) - penalty[r] - AAWL * (ys[d - 2] - ys[1]) - DDWL * disty[r];
+            score[nbp] = (double) (xs[r + 1] - xs[r - 1]) - penalty[r] - AAWL * (ys[d - 2] - ys[1]) - DDWL * (double) disty[r];
         else
-            score[nbp] = (xs[r + 1] - xs[r - 1]) - penalty[r] - BBWL * (ys[si[r] + 1] - ys[si[r] - 1]) - DDWL * disty[r];
+            score[nbp] = (double) (xs[r + 1] - xs[r - 1]) - penalty[r] - BBWL * (ys[si[r] + 1] - ys[si[r] - 1]) - DDWL * (double) disty[r];
         nbp++;
 
         if (s[r] == 0 || s[r] == d - 1)
-            score[nbp] = (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AAWL * (xs[d - 2] - xs[1]) - DDWL * distx[r];
+            score[nbp] = (double) (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AAWL * (xs[d - 2] - xs[1]) - DDWL * (double) distx[r];
         else
-            score[nbp] = (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - BBWL * (xs[s[r] + 1] - xs[s[r] - 1]) - DDWL * distx[r];
+            score[nbp] = (double) (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - BBWL * (xs[s[r] + 1] - xs[s[r] - 1]) - DDWL * (double) distx[r];
         nbp++;
     }
 
@@ -533,6 +553,12 @@ DTYPE flutes_wl_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc) {
 }
 
 Tree flute(int d, DTYPE x[], DTYPE y[], int acc) {
+    return flute(d, x, y, acc, NULL);
+}
+
+// As flute(), the branches written to branch, which holds 2*d-2 branches, if not NULL.
+// The nets of more than D pins are built in malloc'ed trees and copied.
+Tree flute(int d, DTYPE x[], DTYPE y[], int acc, Branch *branch) {
     DTYPE xs[MAXD], ys[MAXD], minval;
     int s[MAXD];
     int i, j, k, minidx;
@@ -545,7 +571,7 @@ Tree flute(int d, DTYPE x[], DTYPE y[], int acc) {
     if (d == 2) {
         t.deg = 2;
         t.length = ADIFF(x[0], x[1]) + ADIFF(y[0], y[1]);
-        t.branch = (Branch *) malloc(2 * sizeof(Branch));
+        t.branch = branch != NULL ? branch : (Branch *) malloc(2 * sizeof(Branch));
         t.branch[0].x = x[0];
         t.branch[0].y = y[0];
         t.branch[0].n = 1;
@@ -610,7 +636,16 @@ Tree flute(int d, DTYPE x[], DTYPE y[], int acc) {
         ys[d - 1] = ptp[d - 1]->y;
         s[d - 1] = ptp[d - 1]->o;
 
-        t = flutes(d, xs, ys, s, acc);
+        if (branch == NULL) {
+            t = flutes(d, xs, ys, s, acc);
+        } else if (d <= D) {  // no duplicate pin left for flutes_RDP() to remove
+            t = flutes_LD(d, xs, ys, s, branch);
+        } else {
+            t = flutes_MD(d, xs, ys, s, acc);
+            memcpy(branch, t.branch, (2 * t.deg - 2) * sizeof(Branch));
+            free(t.branch);
+            t.branch = branch;
+        }
     }
     return t;
 }
@@ -650,7 +685,8 @@ Tree flutes_RDP(int d, DTYPE xs[], DTYPE ys[], int s[], int acc) {
 }
 
 // For low-degree, i.e., 2 <= d <= D
-Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[]) {
+Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[], Branch *branch) {
+    const FluteLUT& lut = readLUT();
     int k, pi, i, j;
     struct csoln *rlist, *bestrlist;
     DTYPE dd[2 * D - 2];  // 0..D-2 for v, D-1..2*D-3 for h
@@ -659,7 +695,7 @@ Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[]) {
     Tree t;
 
     t.deg = d;
-    t.branch = (Branch *) malloc((2 * d - 2) * sizeof(Branch));
+    t.branch = branch != NULL ? branch : (Branch *) malloc((2 * d - 2) * sizeof(Branch));
     if (d == 2) {
         minl = xs[1] - xs[0] + ys[1] - ys[0];
         t.branch[0].x = xs[s[0]];
@@ -713,13 +749,13 @@ Tree flutes_LD(int d, DTYPE xs[], DTYPE ys[], int s[]) {
         }
 
         minl = l[0] = xs[d - 1] - xs[0] + ys[d - 1] - ys[0];
-        rlist = LUT[d][k];
+        rlist = lut.LUT[d][k];
         for (i = 0; rlist->seg[i] > 0; i++)
             minl += dd[rlist->seg[i]];
         bestrlist = rlist;
         l[1] = minl;
         j = 2;
-        while (j <= numsoln[d][k]) {
+        while (j <= lut.numsoln[d][k]) {
             rlist++;
             sum = l[rlist->parent];
             for (i = 0; rlist->seg[i] > 0; i++)
@@ -940,19 +976,19 @@ Tree flutes_MD(int d, DTYPE xs[], DTYPE ys[], int s[], int acc) {
     nbp = 0;
     for (r = lb; r <= ub; r++) {
         if (si[r] <= 1)
-            score[nbp] = (xs[r + 1] - xs[r - 1]) - penalty[r] - AA * (ys[2] - ys[1]) - DD * disty[r];
+            score[nbp] = (double) (xs[r + 1] - xs[r - 1]) - penalty[r] - AA * (ys[2] - ys[1]) - DD * (double) disty[r];
         else if (si[r] >= d - 2)
-            score[nbp] = (xs[r + 1] - xs[r - 1]) - penalty[r] - AA * (ys[d - 2] - ys[d - 3]) - DD * disty[r];
+            score[nbp] = (double) (xs[r + 1] - xs[r - 1]) - penalty[r] - AA * (ys[d - 2] - ys[d - 3]) - DD * (double) disty[r];
         else
-            score[nbp] = (xs[r + 1] - xs[r - 1]) - penalty[r] - BB * (ys[si[r] + 1] - ys[si[r] - 1]) - DD * disty[r];
+            score[nbp] = (double) (xs[r + 1] - xs[r - 1]) - penalty[r] - BB * (ys[si[r] + 1] - ys[si[r] - 1]) - DD * (double) disty[r];
         nbp++;
 
         if (s[r] <= 1)
-            score[nbp] = (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AA * (xs[2] - xs[1]) - DD * distx[r];
+            score[nbp] = (double) (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AA * (xs[2] - xs[1]) - DD * (double) distx[r];
         else if (s[r] >= d - 2)
-            score[nbp] = (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AA * (xs[d - 2] - xs[d - 3]) - DD * distx[r];
+            score[nbp] = (double) (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - AA * (xs[d - 2] - xs[d - 3]) - DD * (double) distx[r];
         else
-            score[nbp] = (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - BB * (xs[s[r] + 1] - xs[s[r] - 1]) - DD * distx[r];
+            score[nbp] = (double) (ys[r + 1] - ys[r - 1]) - penalty[s[r]] - BB * (xs[s[r] + 1] - xs[s[r] - 1]) - DD * (double) distx[r];
         nbp++;
     }
 
@@ -1328,7 +1364,7 @@ void local_refinement(Tree *tp, int p) {
             ys[ii] = tp->branch[index[ii]].y;
         }
 
-        tt = flutes_LD(dd, xs, ys, ss);
+        tt = flutes_LD(dd, xs, ys, ss, NULL);
 
 // Find new wirelength
         tp->length += tt.length;
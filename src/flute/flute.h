@@ -23,7 +23,7 @@
 #define flutes_wl_LMD(d, xs, ys, s, acc) \
     (d<=D ? flutes_wl_LD(d, xs, ys, s) : flutes_wl_MD(d, xs, ys, s, acc))
 #define flutes_LMD(d, xs, ys, s, acc) \
-    (d<=D ? flutes_LD(d, xs, ys, s) : flutes_MD(d, xs, ys, s, acc))
+    (d<=D ? flutes_LD(d, xs, ys, s, NULL) : flutes_MD(d, xs, ys, s, acc))
 
 #define max(x,y) ((x)>(y)?(x):(y))
 #define min(x,y) ((x)<(y)?(x):(y))
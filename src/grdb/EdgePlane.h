@@ -15,6 +15,7 @@
 #include <cstddef>
 #include <exception>
 #include <string>
+#include <utility>
 
 #include "../misc/geometry.h"
 
@@ -178,6 +179,9 @@ public:
 
     const std::size_t num_elements() const;
 
+    ///@brief Get the 2 vertices of the edge at the specified position of all()
+    std::pair<Coordinate_2d, Coordinate_2d> vertices(std::size_t index) const;
+
     ///@brief Get the specified edge
     const T& east(const Coordinate_2d& c) const;
 
@@ -315,6 +319,16 @@ const std::size_t EdgePlane<T>::num_elements() const {
     return edgePlane_.num_elements();
 }
 
+template<class T>
+std::pair<Coordinate_2d, Coordinate_2d> EdgePlane<T>::vertices(std::size_t index) const {
+    const int xy = index / 2;
+    Coordinate_2d c1 { xy / getYSize(), xy % getYSize() };
+    if (index % 2 == EAST) {
+        return std::make_pair(c1, Coordinate_2d { c1.x + 1, c1.y });
+    }
+    return std::make_pair(c1, Coordinate_2d { c1.x, c1.y + 1 });
+}
+
 ///@brief The data structure for presenting the routing edges in global routing area.
 ///@details User can specify the data structure of routing edges by their own, and
 ///         the default data structure of routing edges is a integer.
@@ -0,0 +1,72 @@
+// File: misc/StripedLock.h
+// Brief: Spin locks shared by stripes of objects, and the update policies using them
+
+#ifndef INC_STRIPEDLOCK_H
+#define INC_STRIPEDLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace NTHUR {
+/**
+ @brief Fixed array of spin locks, an object being guarded by the lock of its address.
+ @details Meant for short critical sections on many small objects (e.g. the edges of
+          a grid) that would not afford a mutex each.
+ **/
+class StripedLock {
+public:
+    static constexpr int STRIPES = 1024;
+
+    class Guard {
+    public:
+        Guard(StripedLock& locks, const void* key) :
+                lock_(locks.stripe(key)) {
+            while (lock_.exchange(true, std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        ~Guard() {
+            lock_.store(false, std::memory_order_release);
+        }
+        Guard(const Guard&) = delete;
+        void operator=(const Guard&) = delete;
+
+    private:
+        std::atomic<bool>& lock_;
+    };
+
+    StripedLock() :
+            stripes_ { } {
+    }
+
+private:
+    struct Stripe {
+        std::atomic<bool> locked;
+        char pad[63];       //one stripe per cache line
+    };
+
+    std::atomic<bool>& stripe(const void* key) {
+        return stripes_[(reinterpret_cast<std::uintptr_t>(key) >> 6) % STRIPES].locked;
+    }
+
+    std::array<Stripe, STRIPES> stripes_;
+};
+
+///@brief Update policy of code run by a single thread: guards do nothing
+struct SerialPolicy {
+    struct Guard {
+        Guard(StripedLock&, const void*) {
+        }
+    };
+};
+
+///@brief Update policy of code run concurrently: guards lock the stripe of the object
+struct ConcurrentPolicy {
+    typedef StripedLock::Guard Guard;
+};
+
+} // namespace NTHUR
+
+#endif //INC_STRIPEDLOCK_H
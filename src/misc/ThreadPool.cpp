@@ -0,0 +1,174 @@
+// File: misc/ThreadPool.cpp
+// Brief: Fixed set of worker threads running blocking parallel loops
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace NTHUR {
+
+ThreadPool::ThreadPool(int threads) :
+        body_(nullptr), steals_(0), generation_(0), running_(0), stop_(false) {
+    threads = std::max(threads, 1);
+    for (int i = 0; i < threads; ++i) {
+        queues_.emplace_back(new Queue);
+    }
+    for (int i = 1; i < threads; ++i) {
+        threads_.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& t : threads_) {
+        t.join();
+    }
+}
+
+void ThreadPool::parallel_for(const std::string& name, int n, const LoopBody& body) {
+    Clock::time_point start = Clock::now();
+    Timing& timing = timing_[name];
+    ++timing.loops;
+    timing.items += std::max(n, 0);
+
+    if (threads_.empty() || n <= 1) {
+        for (int i = 0; i < n; ++i) {
+            body(i, 0);
+        }
+        std::chrono::duration<double> d = Clock::now() - start;
+        timing.wall += d.count();
+        timing.busy += d.count();
+        return;
+    }
+
+    int workers = size();
+    for (int w = 0; w < workers; ++w) {
+        Queue& q = *queues_[w];
+        q.begin = (long) n * w / workers;
+        q.end = (long) n * (w + 1) / workers;
+        q.busy = 0.;
+    }
+    steals_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        running_ = threads_.size();
+        ++generation_;
+    }
+    start_.notify_all();
+
+    runLoop(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] {return running_ == 0;});
+    body_ = nullptr;
+
+    std::chrono::duration<double> d = Clock::now() - start;
+    timing.wall += d.count();
+    for (const std::unique_ptr<Queue>& q : queues_) {
+        timing.busy += q->busy;
+    }
+    timing.steals += steals_;
+}
+
+void ThreadPool::run(const std::string& name, const std::vector<Task>& tasks) {
+    parallel_for(name, tasks.size(), [&](int i, int worker) {
+        tasks[i](worker);
+    });
+}
+
+//take a few indices from the front of the queue of the worker
+bool ThreadPool::pop(int worker, int& begin, int& end) {
+    Queue& q = *queues_[worker];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.begin >= q.end) {
+        return false;
+    }
+    begin = q.begin;
+    q.begin += std::max(1, (q.end - q.begin) / 8);
+    end = q.begin;
+    return true;
+}
+
+//move the back half of the indices of another worker to the queue of the worker
+bool ThreadPool::steal(int worker) {
+    int workers = size();
+    for (int k = 1; k < workers; ++k) {
+        Queue& victim = *queues_[(worker + k) % workers];
+        int begin;
+        int end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin >= victim.end) {
+                continue;
+            }
+            end = victim.end;
+            victim.end -= (victim.end - victim.begin + 1) / 2;
+            begin = victim.end;
+        }
+        Queue& q = *queues_[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.begin = begin;
+        q.end = end;
+        ++steals_;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runLoop(int worker) {
+    Clock::time_point start = Clock::now();
+    int begin;
+    int end;
+    do {
+        while (pop(worker, begin, end)) {
+            for (int i = begin; i < end; ++i) {
+                (*body_)(i, worker);
+            }
+        }
+    } while (steal(worker));
+    std::chrono::duration<double> d = Clock::now() - start;
+    queues_[worker]->busy = d.count();
+}
+
+void ThreadPool::work(int worker) {
+    int generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] {return stop_ || generation != generation_;});
+            if (stop_) {
+                return;
+            }
+            generation = generation_;
+        }
+
+        runLoop(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
+        }
+        done_.notify_one();
+    }
+}
+
+std::string ThreadPool::timingToString() const {
+    std::string s;
+    char line[256];
+    for (const std::pair<const std::string, Timing>& t : timing_) {
+        const Timing& tm = t.second;
+        double efficiency = tm.wall > 0. ? tm.busy / (tm.wall * size()) : 1.;
+        std::snprintf(line, sizeof(line), "%-24s loops %6d items %9ld steals %7ld wall %9.3fs busy %9.3fs efficiency %5.1f%%\n", //
+                t.first.c_str(), tm.loops, tm.items, tm.steals, tm.wall, tm.busy, 100. * efficiency);
+        s += line;
+    }
+    return s;
+}
+
+} // namespace NTHUR
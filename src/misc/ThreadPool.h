@@ -0,0 +1,107 @@
+// File: misc/ThreadPool.h
+// Brief: Fixed set of worker threads running blocking parallel loops
+
+#ifndef INC_THREADPOOL_H
+#define INC_THREADPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NTHUR {
+/**
+ @brief Fixed set of worker threads running blocking parallel loops.
+ @details The calling thread takes part in every loop as worker 0, so a pool
+          of size 1 does not start any thread and runs everything inline.
+          The indices of a loop are split evenly among the workers, and a
+          worker running out of indices steals half of the indices left to
+          another one. Every loop is named, and its timing is accumulated
+          under that name. Loops cannot be nested.
+ **/
+class ThreadPool {
+public:
+    /// body of a parallel loop: (index, worker id in [0, size()))
+    typedef std::function<void(int i, int worker)> LoopBody;
+    /// independent task: (worker id in [0, size()))
+    typedef std::function<void(int worker)> Task;
+
+    /// accumulated timing of the loops of a name
+    struct Timing {
+        int loops;
+        long items;
+        long steals;
+        double wall;        ///< seconds spent in the loops
+        double busy;        ///< seconds spent by all the workers in the loop bodies
+
+        Timing() :
+                loops(0), items(0), steals(0), wall(0.), busy(0.) {
+        }
+    };
+
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+    /// Number of workers, calling thread included
+    int size() const {
+        return threads_.size() + 1;
+    }
+
+    /// Run body(i, worker) for every i in [0, n) and wait for all of them
+    void parallel_for(const std::string& name, int n, const LoopBody& body);
+
+    /// Run all the tasks and wait for them
+    void run(const std::string& name, const std::vector<Task>& tasks);
+
+    const std::map<std::string, Timing>& timing() const {
+        return timing_;
+    }
+    std::string timingToString() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// indices [begin, end) left to a worker
+    struct Queue {
+        std::mutex mutex;
+        int begin;
+        int end;
+        double busy;        ///< seconds spent in the current loop
+
+        Queue() :
+                begin(0), end(0), busy(0.) {
+        }
+    };
+
+    void work(int worker);
+    void runLoop(int worker);
+    bool pop(int worker, int& begin, int& end);
+    bool steal(int worker);
+
+    std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::mutex mutex_;
+    std::condition_variable start_;     ///< a new loop is available
+    std::condition_variable done_;      ///< a worker finished the current loop
+
+    const LoopBody* body_;
+    std::atomic<long> steals_;
+    int generation_;                    ///< incremented for every loop
+    int running_;                       ///< threads still inside the current loop
+    bool stop_;
+
+    std::map<std::string, Timing> timing_;
+};
+
+} // namespace NTHUR
+
+#endif //INC_THREADPOOL_H
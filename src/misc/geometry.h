@@ -38,6 +38,8 @@ public:
             x { c.x }, y { c.y } {
     }
 
+    Coordinate_2d& operator=(const Coordinate_2d&) = default;
+
     bool operator==(const Coordinate_2d& other) const {
         return (x == other.x && y == other.y);
     }
@@ -149,6 +151,7 @@ public:
     bool contains(const Coordinate_2d& c) const;
     bool contains(const Rectangle& r) const;
     void expand(int i);
+    void extend(const Coordinate_2d& c);
 
     void clip(Rectangle& r) const;
 
@@ -178,6 +181,13 @@ void Rectangle::expand(int i) {
     downRight.y += i;
 }
 inline
+void Rectangle::extend(const Coordinate_2d& c) {
+    upLeft.x = std::min(upLeft.x, c.x);
+    upLeft.y = std::min(upLeft.y, c.y);
+    downRight.x = std::max(downRight.x, c.x);
+    downRight.y = std::max(downRight.y, c.y);
+}
+inline
 void Rectangle::clip(Rectangle& r) const {
     r.upLeft.x = std::max(upLeft.x, r.upLeft.x);
     r.upLeft.y = std::max(upLeft.y, r.upLeft.y);
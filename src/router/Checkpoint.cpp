@@ -0,0 +1,380 @@
+/*
+ * Checkpoint.cpp
+ *
+ * Routing state saved between the rip-up and reroute iterations, so that an
+ * interrupted run can be resumed.
+ */
+
+#include "Checkpoint.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "../grdb/RoutingRegion.h"
+#include "../spdlog/details/spdlog_impl.h"
+#include "../spdlog/logger.h"
+#include "../spdlog/spdlog.h"
+#include "CoarseGrid.h"
+#include "Congestion.h"
+#include "Construct_2d_tree.h"
+#include "IterationControl.h"
+
+namespace NTHUR {
+
+namespace {
+
+constexpr char magic[] = "NTHURCKP";
+constexpr int version = 3;
+
+//Path steps to the next point, any other step is written in full
+enum Step {
+    X_PLUS, X_MINUS, Y_PLUS, Y_MINUS, SAME, JUMP
+};
+
+//Variable length integers: 7 bits per byte, zigzag for the signed ones
+class Writer {
+public:
+    std::string buffer;
+
+    void put(uint64_t v) {
+        while (v >= 0x80) {
+            buffer.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back(static_cast<char>(v));
+    }
+    void put_int(int64_t v) {
+        put((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+    void put_double(double v) {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, &v, sizeof(double));
+        buffer.append(bytes, sizeof(double));
+    }
+    void put_path(const std::vector<Coordinate_2d>& path) {
+        put(path.size());
+        for (std::size_t i = 0; i < path.size(); ++i) {
+            const Coordinate_2d& c = path[i];
+            if (i == 0) {
+                put_int(c.x);
+                put_int(c.y);
+                continue;
+            }
+            const Coordinate_2d& pre = path[i - 1];
+            Step step = JUMP;
+            if (c.y == pre.y && c.x == pre.x + 1) {
+                step = X_PLUS;
+            } else if (c.y == pre.y && c.x == pre.x - 1) {
+                step = X_MINUS;
+            } else if (c.x == pre.x && c.y == pre.y + 1) {
+                step = Y_PLUS;
+            } else if (c.x == pre.x && c.y == pre.y - 1) {
+                step = Y_MINUS;
+            } else if (c == pre) {
+                step = SAME;
+            }
+            buffer.push_back(static_cast<char>(step));
+            if (step == JUMP) {
+                put_int(c.x);
+                put_int(c.y);
+            }
+        }
+    }
+};
+
+class Reader {
+public:
+    Reader(const std::string& buffer) :
+            buffer(buffer), pos(0) {
+    }
+
+    bool good() const {
+        return pos <= buffer.size();
+    }
+    void skip(std::size_t n) {
+        pos += n;
+    }
+    uint64_t get() {
+        uint64_t v = 0;
+        for (int shift = 0; pos < buffer.size(); shift += 7) {
+            unsigned char byte = buffer[pos++];
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                return v;
+            }
+        }
+        pos = buffer.size() + 1;
+        return 0;
+    }
+    int64_t get_int() {
+        uint64_t v = get();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    double get_double() {
+        double v = 0;
+        if (pos + sizeof(double) <= buffer.size()) {
+            std::memcpy(&v, buffer.data() + pos, sizeof(double));
+        }
+        pos += sizeof(double);
+        return v;
+    }
+    void get_path(std::vector<Coordinate_2d>& path) {
+        path.resize(get());
+        for (std::size_t i = 0; i < path.size() && good(); ++i) {
+            Coordinate_2d& c = path[i];
+            if (i == 0) {
+                c.x = get_int();
+                c.y = get_int();
+                continue;
+            }
+            c = path[i - 1];
+            switch (pos < buffer.size() ? buffer[pos++] : static_cast<char>(JUMP)) {
+            case X_PLUS:
+                ++c.x;
+                break;
+            case X_MINUS:
+                --c.x;
+                break;
+            case Y_PLUS:
+                ++c.y;
+                break;
+            case Y_MINUS:
+                --c.y;
+                break;
+            case SAME:
+                break;
+            default:
+                c.x = get_int();
+                c.y = get_int();
+                break;
+            }
+        }
+    }
+
+private:
+    const std::string& buffer;
+    std::size_t pos;
+};
+
+} // namespace
+
+Checkpoint::Checkpoint(const std::string& fileName, int interval) :
+        fileName { fileName }, //
+        interval { interval } {
+    log_sp = spdlog::get("NTHUR");
+}
+
+Checkpoint::~Checkpoint() {
+    wait();
+}
+
+void Checkpoint::wait() {
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void Checkpoint::save(int done, const Position& position, const Construct_2d_tree& tree) {
+    if (fileName.empty() || interval <= 0 || done <= 0 || done % interval != 0) {
+        return;
+    }
+    const Congestion& congestion = tree.congestion;
+    Writer w;
+    w.buffer.append(magic, sizeof(magic) - 1);
+    w.put(version);
+    w.put(tree.rr_map.get_gridx());
+    w.put(tree.rr_map.get_gridy());
+    w.put(tree.rr_map.get_netNumber());
+    w.put(position.stage);
+    w.put(position.iteration);
+    w.put_int(congestion.cur_iter);
+    w.put_int(tree.done_iter);
+    w.put_int(tree.BOXSIZE_INC);
+    //the costs of the last main stage iteration are kept by the post processing
+    w.put_double(congestion.factor);
+    w.put_double(congestion.WL_Cost);
+    w.put_int(congestion.via_cost);
+    //the samples of the stall watch are timed by their age, the interruption is not measured
+    const IterationControl& control = tree.control;
+    const IterationControl::Clock::time_point now = IterationControl::Clock::now();
+    w.put_int(control.escalations);
+    w.put(control.samples.size());
+    for (const IterationControl::Sample& sample : control.samples) {
+        w.put_int(sample.overflow);
+        w.put_double(std::chrono::duration<double>(now - sample.time).count());
+    }
+
+    for (char dirty : tree.NetDirtyBit) {
+        w.put(dirty);
+    }
+    for (const TreeFlute& flute : tree.net_flutetree) {
+        w.put_int(flute.deg);
+        w.put_double(flute.length);
+        w.put_int(flute.number);
+        w.put(flute.branch.size());
+        for (const Branch& b : flute.branch) {
+            w.put_int(static_cast<int>(b.x));
+            w.put_int(static_cast<int>(b.y));
+            w.put_int(b.n);
+        }
+    }
+    w.put(tree.two_pin_list.size());
+    for (const Two_pin_element_2d& two_pin : tree.two_pin_list) {
+        w.put_int(two_pin.pin1.x);
+        w.put_int(two_pin.pin1.y);
+        w.put_int(two_pin.pin2.x);
+        w.put_int(two_pin.pin2.y);
+        w.put(two_pin.net_id);
+        w.put_int(two_pin.done);
+        w.put_path(two_pin.path);
+    }
+    for (const Edge_2d& edge : congestion.congestionMap2d.all()) {
+        w.put(static_cast<uint64_t>(edge.cur_cap));
+        w.put(edge.history);
+        w.put(edge.used_net.size());
+        for (const std::pair<const int, int>& net : edge.used_net) {
+            w.put(net.first);
+            w.put(net.second);
+        }
+    }
+    const CoarseGrid* coarseGrid = congestion.coarseGrid.get();
+    w.put(coarseGrid ? coarseGrid->tileSize : 0);
+    if (coarseGrid) {
+        w.put(coarseGrid->stamp.load());
+        for (const CoarseGrid::CoarseEdge& edge : coarseGrid->coarseMap.all()) {
+            w.put(edge.flip);
+        }
+        w.put(coarseGrid->cache.size());
+        for (const auto& cached : coarseGrid->cache) {
+            w.put(cached.first.net_id);
+            w.put(cached.second.stamp);
+            w.put_path( { cached.first.t1, cached.first.t2 });
+            w.put_path(cached.second.tiles);
+        }
+    }
+
+    //the previous checkpoint is complete before the new one is written
+    wait();
+    log_sp->info("checkpoint of stage {} iteration {}: {} bytes to {}", position.stage, position.iteration, w.buffer.size(), fileName);
+    writer = std::thread([this](std::string buffer) {
+        std::string tmp = fileName + ".tmp";
+        std::ofstream ofs(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+        ofs.write(buffer.data(), buffer.size());
+        ofs.close();
+        if (!ofs || std::rename(tmp.c_str(), fileName.c_str()) != 0) {
+            log_sp->error("checkpoint {} not written", fileName);
+        }
+    }, std::move(w.buffer));
+}
+
+Checkpoint::Position Checkpoint::load(const std::string& fileName, Construct_2d_tree& tree) {
+    std::shared_ptr<spdlog::logger> log_sp = spdlog::get("NTHUR");
+    std::ifstream ifs(fileName, std::ifstream::in | std::ifstream::binary);
+    std::string buffer { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+    Reader r(buffer);
+    if (!ifs || buffer.compare(0, sizeof(magic) - 1, magic) != 0) {
+        log_sp->error("{} is not a checkpoint", fileName);
+        exit(-1);
+    }
+    r.skip(sizeof(magic) - 1);
+    if (r.get() != version || r.get() != static_cast<uint64_t>(tree.rr_map.get_gridx()) || r.get() != static_cast<uint64_t>(tree.rr_map.get_gridy())
+            || r.get() != tree.rr_map.get_netNumber()) {
+        log_sp->error("checkpoint {} is not a checkpoint of this version and this input", fileName);
+        exit(-1);
+    }
+
+    Congestion& congestion = tree.congestion;
+    Position position;
+    position.stage = static_cast<Stage>(r.get());
+    position.iteration = r.get();
+    congestion.cur_iter = r.get_int();
+    tree.done_iter = r.get_int();
+    tree.BOXSIZE_INC = r.get_int();
+    congestion.factor = r.get_double();
+    congestion.WL_Cost = r.get_double();
+    congestion.via_cost = r.get_int();
+    IterationControl& control = tree.control;
+    const IterationControl::Clock::time_point now = IterationControl::Clock::now();
+    control.escalations = r.get_int();
+    control.samples.resize(r.get());
+    for (IterationControl::Sample& sample : control.samples) {
+        sample.overflow = r.get_int();
+        sample.time = now - std::chrono::duration_cast<IterationControl::Clock::duration>(std::chrono::duration<double>(r.get_double()));
+    }
+
+    for (char& dirty : tree.NetDirtyBit) {
+        dirty = r.get();
+    }
+    for (TreeFlute& flute : tree.net_flutetree) {
+        flute.deg = r.get_int();
+        flute.length = r.get_double();
+        flute.number = r.get_int();
+        flute.branch.resize(r.get());
+        for (Branch& b : flute.branch) {
+            b.x = r.get_int();
+            b.y = r.get_int();
+            b.n = r.get_int();
+        }
+    }
+    tree.two_pin_list.resize(r.get());
+    for (Two_pin_element_2d& two_pin : tree.two_pin_list) {
+        two_pin.pin1.x = r.get_int();
+        two_pin.pin1.y = r.get_int();
+        two_pin.pin2.x = r.get_int();
+        two_pin.pin2.y = r.get_int();
+        two_pin.net_id = r.get();
+        two_pin.done = r.get_int();
+        r.get_path(two_pin.path);
+    }
+    for (Edge_2d& edge : congestion.congestionMap2d.all()) {
+        edge.cur_cap = r.get();
+        edge.history = r.get();
+        edge.used_net.clear();
+        for (uint64_t n = r.get(); n > 0 && r.good(); --n) {
+            int net = r.get();
+            edge.used_net[net] = r.get();
+        }
+    }
+    CoarseGrid* coarseGrid = congestion.coarseGrid.get();
+    if (r.get() != static_cast<uint64_t>(coarseGrid ? coarseGrid->tileSize : 0)) {
+        log_sp->error("checkpoint {} is not a checkpoint of this coarse tile size", fileName);
+        exit(-1);
+    }
+    if (coarseGrid) {
+        //the usage comes from the congestion map, the cache from the checkpoint
+        coarseGrid->sync();
+        coarseGrid->stamp = r.get();
+        for (CoarseGrid::CoarseEdge& edge : coarseGrid->coarseMap.all()) {
+            edge.flip = r.get();
+        }
+        std::vector<Coordinate_2d> tiles;
+        for (uint64_t n = r.get(); n > 0 && r.good(); --n) {
+            CoarseGrid::PathKey key;
+            CoarseGrid::CachedPath path;
+            key.net_id = r.get();
+            path.stamp = r.get();
+            r.get_path(tiles);
+            r.get_path(path.tiles);
+            if (tiles.size() == 2) {
+                key.t1 = tiles[0];
+                key.t2 = tiles[1];
+                coarseGrid->cache.emplace(key, std::move(path));
+            }
+        }
+    }
+    if (!r.good()) {
+        log_sp->error("checkpoint {} is truncated", fileName);
+        exit(-1);
+    }
+    log_sp->info("resume from {} at stage {} iteration {}", fileName, position.stage, position.iteration);
+    return position;
+}
+
+} // namespace NTHUR
@@ -0,0 +1,66 @@
+/*
+ * Checkpoint.h
+ *
+ * Routing state saved between the rip-up and reroute iterations, so that an
+ * interrupted run can be resumed.
+ */
+
+#ifndef SRC_ROUTER_CHECKPOINT_H_
+#define SRC_ROUTER_CHECKPOINT_H_
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace spdlog {
+class logger;
+} /* namespace spdlog */
+
+namespace NTHUR {
+
+struct Construct_2d_tree;
+
+///@brief Periodic checkpoints of the routing state and resume from them.
+///@details A checkpoint is taken at the start of an iteration, once the 2-pin nets of
+///         the previous one are reallocated. It holds what the next iterations read: the
+///         usage and history of the congestion map edges, two_pin_list with the paths,
+///         net_flutetree, NetDirtyBit, the iteration counters, the stall watch of the main
+///         stage and the path cache of the coarse grid, if any. The edge costs, the coarse
+///         usage and the congestion totals are rebuilt on resume.
+///         The state is encoded on the calling thread, then written to a temporary file
+///         renamed over the checkpoint by a background thread, so that the checkpoint
+///         file is always complete.
+class Checkpoint {
+public:
+    enum Stage {
+        MAIN = 2, REFINEMENT = 3
+    };
+
+    ///@brief Resume position: the stage and the iteration to run
+    struct Position {
+        Stage stage;
+        int iteration;      //congestion.cur_iter in the main stage, post processing iteration in the refinement stage
+    };
+
+    ///@param fileName checkpoint file, no checkpoint if empty
+    ///@param interval iterations between two checkpoints
+    Checkpoint(const std::string& fileName, int interval);
+    ~Checkpoint();
+
+    ///@brief Take a checkpoint before the iteration at position, if the iterations done in its stage make it due
+    void save(int done, const Position& position, const Construct_2d_tree& tree);
+    ///@brief Load the state saved in fileName into tree, and return where to resume
+    static Position load(const std::string& fileName, Construct_2d_tree& tree);
+
+private:
+    std::string fileName;
+    int interval;
+    std::thread writer;     //writes the last checkpoint
+    std::shared_ptr<spdlog::logger> log_sp;
+
+    void wait();
+};
+
+} // namespace NTHUR
+
+#endif /* SRC_ROUTER_CHECKPOINT_H_ */
@@ -0,0 +1,189 @@
+/*
+ * CoarseGrid.cpp
+ *
+ * Coarse view of the 2D congestion map used to steer the maze router on
+ * long connections.
+ */
+
+#include "CoarseGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include "../spdlog/details/spdlog_impl.h"
+#include "../spdlog/logger.h"
+#include "../spdlog/spdlog.h"
+
+namespace NTHUR {
+
+constexpr double blocked_cost = 1000000.;   // cost of a coarse edge without capacity
+constexpr double coarse_exponent = 5.0;
+
+CoarseGrid::CoarseGrid(const EdgePlane<Edge_2d>& congestionMap2d, int tileSize, int minSpan) :
+        tileSize { tileSize }, //
+        minSpan { minSpan }, //
+        routed { 0 }, //
+        reused { 0 }, //
+        congestionMap2d { congestionMap2d }, //
+        coarseMap { (congestionMap2d.getXSize() + tileSize - 1) / tileSize, (congestionMap2d.getYSize() + tileSize - 1) / tileSize }, //
+        stamp { 0 } {
+    log_sp = spdlog::get("NTHUR");
+    sync();
+}
+
+void CoarseGrid::sync() {
+    for (CoarseEdge& e : coarseMap.all()) {
+        e = CoarseEdge { };
+    }
+    for (int x = 0; x < congestionMap2d.getXSize(); ++x) {
+        for (int y = 0; y < congestionMap2d.getYSize(); ++y) {
+            Coordinate_2d c { x, y };
+            if (x + 1 < congestionMap2d.getXSize() && (x + 1) % tileSize == 0) {
+                CoarseEdge& e = coarseMap.east(tile(c));
+                e.cur_cap += congestionMap2d.east(c).cur_cap;
+                e.max_cap += congestionMap2d.east(c).max_cap;
+            }
+            if (y + 1 < congestionMap2d.getYSize() && (y + 1) % tileSize == 0) {
+                CoarseEdge& e = coarseMap.south(tile(c));
+                e.cur_cap += congestionMap2d.south(c).cur_cap;
+                e.max_cap += congestionMap2d.south(c).max_cap;
+            }
+        }
+    }
+    // the stored paths were computed on another demand
+    cache.clear();
+}
+
+template<class Policy>
+void CoarseGrid::update(const Coordinate_2d& c1, const Coordinate_2d& c2, double delta) {
+    Coordinate_2d t1 = tile(c1);
+    Coordinate_2d t2 = tile(c2);
+    if (t1 == t2) {
+        return;
+    }
+    CoarseEdge& e = coarseMap.edge(t1, t2);
+    typename Policy::Guard guard(locks, &e);
+    bool overflow = e.isOverflow();
+    e.cur_cap += delta;
+    if (overflow != e.isOverflow()) {
+        e.flip = ++stamp;
+    }
+}
+
+template void CoarseGrid::update<SerialPolicy>(const Coordinate_2d& c1, const Coordinate_2d& c2, double delta);
+template void CoarseGrid::update<ConcurrentPolicy>(const Coordinate_2d& c1, const Coordinate_2d& c2, double delta);
+
+double CoarseGrid::cost(const CoarseEdge& e) const {
+    if (e.max_cap <= 0) {
+        return blocked_cost;
+    }
+    return 1.0 + std::pow((e.cur_cap + 1) / e.max_cap, coarse_exponent);
+}
+
+bool CoarseGrid::valid(const CachedPath& p) const {
+    for (int i = (int) p.tiles.size() - 2; i >= 0; --i) {
+        if (coarseMap.edge(p.tiles[i], p.tiles[i + 1]).flip > p.stamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Dijkstra on the supertiles of the window [tStart, tEnd]
+void CoarseGrid::route(const Coordinate_2d& t1, const Coordinate_2d& t2, const Coordinate_2d& tStart, const Coordinate_2d& tEnd, std::vector<Coordinate_2d>& tiles) {
+    int height = tEnd.y - tStart.y + 1;
+    int num = (tEnd.x - tStart.x + 1) * height;
+    auto index = [&](const Coordinate_2d& t) {
+        return (t.x - tStart.x) * height + (t.y - tStart.y);
+    };
+
+    std::vector<double> dist(num, std::numeric_limits<double>::max());
+    std::vector<int> parent(num, -1);
+
+    typedef std::pair<double, int> QueueElement;
+    std::priority_queue<QueueElement, std::vector<QueueElement>, std::greater<QueueElement> > pqueue;
+
+    dist[index(t1)] = 0;
+    pqueue.emplace(0., index(t1));
+    while (!pqueue.empty()) {
+        QueueElement top = pqueue.top();
+        pqueue.pop();
+        if (top.first > dist[top.second]) {
+            continue;
+        }
+        if (top.second == index(t2)) {
+            break;
+        }
+        Coordinate_2d cur { tStart.x + top.second / height, tStart.y + top.second % height };
+        for (EdgePlane<CoarseEdge>::Handle& h : coarseMap.neighbors(cur)) {
+            const Coordinate_2d& next = h.vertex();
+            if (next.x < tStart.x || next.y < tStart.y || next.x > tEnd.x || next.y > tEnd.y) {
+                continue;
+            }
+            double d = top.first + cost(h.edge());
+            int i = index(next);
+            if (d < dist[i]) {
+                dist[i] = d;
+                parent[i] = top.second;
+                pqueue.emplace(d, i);
+            }
+        }
+    }
+
+    tiles.clear();
+    for (int i = index(t2); i != -1; i = parent[i]) {
+        tiles.emplace_back(tStart.x + i / height, tStart.y + i % height);
+    }
+}
+
+void CoarseGrid::corridor(int net_id, const Coordinate_2d& pin1, const Coordinate_2d& pin2, const Coordinate_2d& start, const Coordinate_2d& end, Corridor& result) {
+    Coordinate_2d tStart = tile(start);
+    Coordinate_2d tEnd = tile(end);
+    PathKey key { net_id, tile(pin1), tile(pin2) };
+
+    CachedPath path;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            path = it->second;
+        }
+    }
+    //a path cached for a larger window may leave this one, its clamped corridor would be cut
+    bool inside = std::all_of(path.tiles.begin(), path.tiles.end(), [&](const Coordinate_2d& t) {
+        return t.x >= tStart.x && t.x <= tEnd.x && t.y >= tStart.y && t.y <= tEnd.y;
+    });
+    if (!path.tiles.empty() && inside && valid(path)) {
+        ++reused;
+    } else {
+        path.stamp = stamp;
+        route(key.t1, key.t2, tStart, tEnd, path.tiles);
+        ++routed;
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache[key] = path;
+    }
+
+    //the corridor is the coarse path widened by one supertile
+    result.tileSize = tileSize;
+    result.origin = tStart;
+    result.size.set(tEnd.x - tStart.x + 1, tEnd.y - tStart.y + 1);
+    result.mask.assign(result.size.x * result.size.y, 0);
+    for (const Coordinate_2d& t : path.tiles) {
+        for (int x = std::max(t.x - 1, tStart.x); x <= std::min(t.x + 1, tEnd.x); ++x) {
+            for (int y = std::max(t.y - 1, tStart.y); y <= std::min(t.y + 1, tEnd.y); ++y) {
+                result.mask[(x - tStart.x) * result.size.y + (y - tStart.y)] = 1;
+            }
+        }
+    }
+}
+
+void CoarseGrid::logStatistic() const {
+    log_sp->info("coarse corridor: routed {} reused {}", routed, reused);
+}
+
+} // namespace NTHUR
@@ -0,0 +1,142 @@
+/*
+ * CoarseGrid.h
+ *
+ * Coarse view of the 2D congestion map used to steer the maze router on
+ * long connections.
+ */
+
+#ifndef SRC_ROUTER_COARSEGRID_H_
+#define SRC_ROUTER_COARSEGRID_H_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../grdb/EdgePlane.h"
+#include "../misc/geometry.h"
+#include "../misc/StripedLock.h"
+#include "DataDef.h"
+
+namespace spdlog {
+class logger;
+} /* namespace spdlog */
+
+namespace NTHUR {
+
+///@brief Set of supertiles the fine maze search is allowed to walk through.
+class Corridor {
+public:
+    int tileSize;
+    Coordinate_2d origin;       //first tile of the mask
+    Coordinate_2d size;         //mask size in tiles
+    std::vector<char> mask;
+
+    Corridor() :
+            tileSize(1) {
+    }
+
+    bool contains(const Coordinate_2d& c) const {
+        int tx = c.x / tileSize - origin.x;
+        int ty = c.y / tileSize - origin.y;
+        return tx >= 0 && ty >= 0 && tx < size.x && ty < size.y && mask[tx * size.y + ty];
+    }
+};
+
+///@brief Congestion map aggregated in supertiles of tileSize x tileSize GCells.
+///@details A coarse edge between two adjacent supertiles holds the summed capacity and
+///         usage of the fine edges crossing their common boundary. The aggregate is kept
+///         in sync by Congestion each time a fine edge demand changes.
+///         Concurrent callers must work on disjoint sets of supertiles.
+class CoarseGrid {
+public:
+    struct CoarseEdge {
+        double cur_cap;
+        double max_cap;
+        int flip;       //update stamp of the last overflow state change
+
+        CoarseEdge() :
+                cur_cap(0.), max_cap(0.), flip(0) {
+        }
+        bool isOverflow() const {
+            return cur_cap > max_cap;
+        }
+        std::string toString() const {
+            return std::to_string(static_cast<int>(cur_cap)) + "/" + std::to_string(static_cast<int>(max_cap));
+        }
+    };
+
+    int tileSize;
+    int minSpan;        //smallest window (in GCells) routed through a corridor
+
+    std::atomic<int> routed;         //corridors computed
+    std::atomic<int> reused;         //corridors taken from the cache
+
+    CoarseGrid(const EdgePlane<Edge_2d>& congestionMap2d, int tileSize, int minSpan);
+
+    ///@brief Rebuild the whole aggregate from the fine map.
+    void sync();
+
+    ///@brief Report a demand change of delta on the fine edge c1-c2.
+    template<class Policy = SerialPolicy>
+    void update(const Coordinate_2d& c1, const Coordinate_2d& c2, double delta);
+
+    ///@brief Find the corridor of a connection inside the window [start, end].
+    ///@details The coarse path of a connection is cached and reused while none of its
+    ///         coarse edges changed overflow state.
+    void corridor(int net_id, const Coordinate_2d& pin1, const Coordinate_2d& pin2, const Coordinate_2d& start, const Coordinate_2d& end, Corridor& result);
+
+    bool useCorridor(const Coordinate_2d& start, const Coordinate_2d& end) const {
+        return std::max(end.x - start.x, end.y - start.y) >= minSpan;
+    }
+
+    void logStatistic() const;
+
+private:
+    friend class Checkpoint;    //the cached paths and the stamps are saved with the routing state
+
+    struct CachedPath {
+        int stamp;
+        std::vector<Coordinate_2d> tiles;
+    };
+
+    struct PathKey {
+        int net_id;
+        Coordinate_2d t1;
+        Coordinate_2d t2;
+
+        bool operator==(const PathKey& o) const {
+            return net_id == o.net_id && t1 == o.t1 && t2 == o.t2;
+        }
+    };
+
+    struct PathKeyHash {
+        std::size_t operator()(const PathKey& k) const {
+            std::hash<Coordinate_2d> h;
+            return (h(k.t1) * 31 + h(k.t2)) * 31 + k.net_id;
+        }
+    };
+
+    Coordinate_2d tile(const Coordinate_2d& c) const {
+        return Coordinate_2d { c.x / tileSize, c.y / tileSize };
+    }
+    double cost(const CoarseEdge& e) const;
+    bool valid(const CachedPath& p) const;
+    void route(const Coordinate_2d& t1, const Coordinate_2d& t2, const Coordinate_2d& tStart, const Coordinate_2d& tEnd, std::vector<Coordinate_2d>& tiles);
+
+    const EdgePlane<Edge_2d>& congestionMap2d;
+    EdgePlane<CoarseEdge> coarseMap;
+    std::atomic<int> stamp;
+    StripedLock locks;      //guards the coarse edges in ConcurrentPolicy updates
+    std::unordered_map<PathKey, CachedPath, PathKeyHash> cache;
+    std::mutex cacheMutex;
+
+    std::shared_ptr<spdlog::logger> log_sp;
+};
+
+} // namespace NTHUR
+
+#endif /* SRC_ROUTER_COARSEGRID_H_ */
@@ -12,6 +12,7 @@
 #include <boost/range/iterator_range_core.hpp>
 #include <boost/tuple/detail/tuple_basic.hpp>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
@@ -20,7 +21,9 @@
 #include <utility>
 
 #include "../grdb/plane.h"
+#include "CoarseGrid.h"
 #include "../grdb/RoutingRegion.h"
+#include "../misc/ThreadPool.h"
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
 #include "../spdlog/spdlog.h"
@@ -29,19 +32,31 @@ namespace NTHUR {
 
 constexpr double parameter_h = 0.8;         // used in the edge cost function 1/0.5 0.8/2
 constexpr double parameter_k = 2;           // used in the edge cost function
+constexpr int EDGE_CHUNK = 4096;            // edges of a chunk of the whole map sweeps
 }
-NTHUR::Congestion::Congestion(int x, int y) :
-        congestionMap2d { x, y }  //
+NTHUR::Congestion::Congestion(int x, int y, ThreadPool& pool) :
+        congestionMap2d { x, y }, //
+        pool(pool), //
+        total_overflow { 0 }, //
+        total_wirelength { 0 }, //
+        totals_valid { false }, //
+        cost_flag_evaluated { -1 }, //
+        two_pins_indexed { false } //
 {
     exponent = 5.0;
     WL_Cost = 1.0;
     via_cost = 3;
     factor = 1.0;
     cur_iter = -1;                  // current iteration ID.
+    cost_base = 0.0;
     used_cost_flag = FASTROUTE_COST;    // cost function type, i.e., HISTORY_COST, HISTORY_MADEOF_COST, MADEOF_COST, FASTROUTE_COST
     pre_evaluate_congestion_cost_fp = [&]( Edge_2d& edge) {pre_evaluate_congestion_cost_all( edge);};
     log_sp = spdlog::get("NTHUR");
 }
+
+NTHUR::Congestion::~Congestion() {
+}
+
 namespace NTHUR {
 
 //get edge cost on a 2D layer
@@ -57,7 +72,7 @@ double Congestion::get_cost_2d(const Coordinate_2d& c1, const Coordinate_2d& c2,
         switch (used_cost_flag) {
 
         case HISTORY_COST: {    //Used in part II
-            return edge.cost;
+            return edge_cost(edge);
         }
 
         case MADEOF_COST: {    //Used in part III: Post processing
@@ -77,17 +92,36 @@ double Congestion::get_cost_2d(const Coordinate_2d& c1, const Coordinate_2d& c2,
 
 /*==================DEBUG FUNCTION================================*/
 //Obtain the max. overflow and total overflowed value of edges of every gCell
+//The edge costs are refreshed on the way, and the totals are rebuilt
 int Congestion::cal_max_overflow() {
     int max_2d_of = 0;       //max. overflow (2D)
     int dif_curmax = 0;
+    int total_wl = 0;
 
-    for (Edge_2d& edge : congestionMap2d.all()) {
-        pre_evaluate_congestion_cost_fp(edge);
-        if (edge.isOverflow()) {
-            max_2d_of = std::max(max_2d_of, edge.overUsage());
-            dif_curmax += edge.overUsage();
+    scan_overflow(true, dif_curmax, max_2d_of, total_wl);
+
+    total_overflow = dif_curmax;
+    total_wirelength = total_wl;
+    std::vector<std::atomic<int> >(2 * max_2d_of + 64).swap(overflow_histogram);
+    std::vector<std::vector<int> > chunk_overflowed(edge_chunks());
+    sweep_edges("overflow histogram", [&](int chunk, int first, int last) {
+        const Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e = first; e < last; ++e) {
+            if (edges[e].isOverflow()) {
+                overflow_histogram[histogram_bucket(edges[e].overUsage())].fetch_add(1, std::memory_order_relaxed);
+                chunk_overflowed[chunk].push_back(e);
+            }
+        }
+    });
+    overflowed_edges.clear();
+    overflowed_slot.assign(congestionMap2d.all().size(), -1);
+    for (const std::vector<int>& overflowed : chunk_overflowed) {
+        for (int e : overflowed) {
+            overflowed_slot[e] = overflowed_edges.size();
+            overflowed_edges.push_back(e);
         }
     }
+    totals_valid = true;
 
     //obtain the max. overflow and total overflowed value of RIGHT edge of every gCell
 
@@ -97,16 +131,164 @@ int Congestion::cal_max_overflow() {
 
     return dif_curmax;
 }
+
+//Sum of the overflow, max. overflow and wirelength of the whole map, refreshing the edge costs if asked
+void Congestion::scan_overflow(bool refresh_cost, int& overflow, int& max, int& wirelength) {
+    std::vector<int> chunk_max(edge_chunks(), 0);
+    std::vector<int> chunk_dif(edge_chunks(), 0);
+    std::vector<int> chunk_wl(edge_chunks(), 0);
+    sweep_edges("max overflow", [&](int chunk, int first, int last) {
+        Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e = first; e < last; ++e) {
+            Edge_2d& edge = edges[e];
+            if (refresh_cost) {
+                pre_evaluate_congestion_cost_fp(edge);
+            }
+            if (edge.isOverflow()) {
+                chunk_max[chunk] = std::max(chunk_max[chunk], edge.overUsage());
+                chunk_dif[chunk] += edge.overUsage();
+            }
+            chunk_wl[chunk] += (int) edge.cur_cap;
+        }
+    });
+    if (refresh_cost) {
+        refresh_cost_base();
+        cost_flag_evaluated = used_cost_flag;
+    }
+    overflow = 0;
+    max = 0;
+    wirelength = 0;
+    for (int chunk = 0; chunk < edge_chunks(); ++chunk) {
+        max = std::max(max, chunk_max[chunk]);
+        overflow += chunk_dif[chunk];
+        wirelength += chunk_wl[chunk];
+    }
+}
+
+int Congestion::histogram_bucket(int overUsage) const {
+    return std::min<int>(overUsage, overflow_histogram.size() - 1);
+}
+
+int Congestion::histogram_max() const {
+    for (int i = overflow_histogram.size() - 1; i > 0; --i) {
+        if (overflow_histogram[i].load(std::memory_order_relaxed) > 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+//Account for the usage change of an edge, from before to edge.cur_cap.
+//An edge leaving overflowed_edges is replaced by the last one. The index is shared by all the
+//edges, so it is locked even with SerialPolicy: the reroute waves update disjoint edges concurrently.
+void Congestion::update_totals(const Edge_2d& edge, double before) {
+    if (!totals_valid) {
+        return;
+    }
+    total_wirelength.fetch_add((int) edge.cur_cap - (int) before, std::memory_order_relaxed);
+    if ((before > edge.max_cap) != edge.isOverflow()) {
+        int e = &edge - congestionMap2d.all().begin();
+        std::lock_guard<std::mutex> lock(overflowed_mutex);
+        if (edge.isOverflow()) {
+            overflowed_slot[e] = overflowed_edges.size();
+            overflowed_edges.push_back(e);
+        } else {
+            int last = overflowed_edges.back();
+            overflowed_edges[overflowed_slot[e]] = last;
+            overflowed_slot[last] = overflowed_slot[e];
+            overflowed_edges.pop_back();
+            overflowed_slot[e] = -1;
+        }
+    }
+    if (before > edge.max_cap) {
+        int overUsage = static_cast<int>(before - edge.max_cap);
+        total_overflow.fetch_sub(overUsage, std::memory_order_relaxed);
+        overflow_histogram[histogram_bucket(overUsage)].fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (edge.isOverflow()) {
+        total_overflow.fetch_add(edge.overUsage(), std::memory_order_relaxed);
+        overflow_histogram[histogram_bucket(edge.overUsage())].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//Same report as cal_max_overflow() from the totals, without refreshing the edge costs.
+//With the debug log level, the totals are checked against a full scan.
+int Congestion::report_max_overflow() {
+    if (!totals_valid) {
+        return cal_max_overflow();
+    }
+    int max_2d_of = histogram_max();
+    if (max_2d_of == static_cast<int>(overflow_histogram.size()) - 1) {
+        //the last bucket holds the larger overflows, rebuild the histogram
+        return cal_max_overflow();
+    }
+    int dif_curmax = total_overflow.load(std::memory_order_relaxed);
+    check_totals();
+
+    log_sp->info("cal max overflow= {} cur_cap-max_cap= {}", max_2d_of, dif_curmax);
+    return dif_curmax;
+}
+
+//Same report as cal_total_wirelength() from the totals
+int Congestion::report_total_wirelength() {
+    if (!totals_valid) {
+        return cal_total_wirelength();
+    }
+    check_totals();
+    int total_wl = total_wirelength.load(std::memory_order_relaxed);
+    log_sp->info("total wire length: {}", total_wl);
+    return total_wl;
+}
+
+const std::vector<int>& Congestion::sort_overflowed_edges() {
+    std::sort(overflowed_edges.begin(), overflowed_edges.end());
+    for (std::size_t i = 0; i < overflowed_edges.size(); ++i) {
+        overflowed_slot[overflowed_edges[i]] = i;
+    }
+    return overflowed_edges;
+}
+
+//With the debug log level, report any difference between the totals and a full scan
+void Congestion::check_totals() {
+    if (!log_sp->should_log(spdlog::level::debug)) {
+        return;
+    }
+    int overflow;
+    int max;
+    int wirelength;
+    scan_overflow(false, overflow, max, wirelength);
+    int max_2d_of = histogram_max();
+    std::size_t overflowed = 0;
+    for (const Edge_2d& edge : congestionMap2d.all()) {
+        if (edge.isOverflow()) {
+            ++overflowed;
+            int e = &edge - congestionMap2d.all().begin();
+            if (overflowed_slot[e] < 0 || overflowed_edges[overflowed_slot[e]] != e) {
+                log_sp->error("overflowed edge {} missing from the index", e);
+            }
+        }
+    }
+    if (overflowed != overflowed_edges.size() || overflow != total_overflow || max != max_2d_of || wirelength != total_wirelength) {
+        log_sp->error("congestion totals overflow {} max {} wirelength {} edges {} vs scan {} {} {} {}", total_overflow.load(), max_2d_of,
+                total_wirelength.load(), overflowed_edges.size(), overflow, max, wirelength, overflowed);
+        return;
+    }
+    log_sp->debug("congestion totals checked");
+}
 /* *NOTICE*
  * You can create many different cost function for difference case easily,
  * just reassign function pointer pre_evaluate_congestion_cost_fp to your
- * function in *route/route.cpp* .                                        */
+ * function in *route/route.cpp* .
+ * The function sets the edge part of the cost, cost_base is added at lookup.
+ * Between two iterations, only the edges with history > 1 are refreshed by
+ * pre_evaluate_congestion_cost(), so a history of 1 must make the edge part
+ * independent of cur_iter and factor.                                    */
 
 void Congestion::pre_evaluate_congestion_cost_all(Edge_2d& edge) const {
     static const int inc = 1;
     if (used_cost_flag == HISTORY_COST) {
         double cong = (edge.cur_cap + inc) / (edge.max_cap * (1.0 - ((edge.history - 1) / (cur_iter * (1.5 + 3 * factor)))));
-        edge.cost = WL_Cost + (edge.history) * pow(cong, exponent);
+        edge.cost = (edge.history) * pow(cong, exponent);
     } else {
         if (edge.isFull())
             edge.cost = 1.0;
@@ -115,16 +297,70 @@ void Congestion::pre_evaluate_congestion_cost_all(Edge_2d& edge) const {
     }
 }
 
-void Congestion::pre_evaluate_congestion_cost() {
-
+//With the debug log level, the cached edge costs are checked against a full refresh
+void Congestion::check_costs() {
+    if (!log_sp->should_log(spdlog::level::debug)) {
+        return;
+    }
+    int mismatches = 0;
     for (Edge_2d& edge : congestionMap2d.all()) {
+        double cost = edge.cost;
         pre_evaluate_congestion_cost_fp(edge);
+        if (edge.cost != cost) {
+            if (mismatches++ == 0) {
+                log_sp->error("edge cost {} vs refresh {}", cost, edge.cost);
+            }
+        }
+    }
+    if (mismatches > 0) {
+        log_sp->error("{} cached edge costs refreshed", mismatches);
+        return;
+    }
+    log_sp->debug("congestion costs checked");
+}
 
-        if (edge.isOverflow()) {
-            ++edge.history;
+void Congestion::refresh_cost_base() {
+    cost_base = (used_cost_flag == HISTORY_COST) ? WL_Cost : 0.0;
+}
+
+//Refresh the edge costs for the new iteration, then increase the history of the overflowed edges.
+//Once the costs of the current cost function are cached and the overflowed edges are indexed,
+//only the edges with history > 1 are refreshed, the other ones are kept up to date by the 2-pin net updates.
+void Congestion::pre_evaluate_congestion_cost() {
+    refresh_cost_base();
+    Edge_2d* edges = congestionMap2d.all().begin();
+    if (totals_valid && cost_flag_evaluated == used_cost_flag) {
+        pool.parallel_for("congestion cost", history_edges.size(), [&](int i, int) {
+            pre_evaluate_congestion_cost_fp(edges[history_edges[i]]);
+        });
+        check_costs();
+        for (int e : overflowed_edges) {
+            if (++edges[e].history == 2) {
+                history_edges.push_back(e);
+            }
         }
+    } else {
+        std::vector<std::vector<int> > chunk_history(edge_chunks());
+        sweep_edges("congestion cost", [&](int chunk, int first, int last) {
+            for (int e = first; e < last; ++e) {
+                Edge_2d& edge = edges[e];
+                pre_evaluate_congestion_cost_fp(edge);
 
-    }SPDLOG_TRACE(log_sp, "pre_evaluate_congestion_cost gridEdge \n{}", congestionMap2d.toString());
+                if (edge.isOverflow()) {
+                    ++edge.history;
+                }
+                if (edge.history > 1) {
+                    chunk_history[chunk].push_back(e);
+                }
+            }
+        });
+        history_edges.clear();
+        for (const std::vector<int>& history : chunk_history) {
+            history_edges.insert(history_edges.end(), history.begin(), history.end());
+        }
+        cost_flag_evaluated = used_cost_flag;
+    }
+    SPDLOG_TRACE(log_sp, "pre_evaluate_congestion_cost gridEdge \n{}", congestionMap2d.toString());
 }
 
 //Check if the specified edge is not overflowed
@@ -156,11 +392,19 @@ bool Congestion::check_path_no_overflow(const std::vector<Coordinate_2d>& path,
 
 int Congestion::find_overflow_max(int max_zz) const {
     int overflow_max = 0;
-    for (const Edge_2d& edge : congestionMap2d.all()) {
-        if (edge.overUsage() > overflow_max) {
-            overflow_max = edge.overUsage();
+    std::vector<int> chunk_max(edge_chunks(), 0);
+    sweep_edges("overflow max", [&](int chunk, int first, int last) {
+        const Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e = first; e < last; ++e) {
+            if (edges[e].overUsage() > chunk_max[chunk]) {
+                chunk_max[chunk] = edges[e].overUsage();
+            }
         }
-    }SPDLOG_TRACE(log_sp, "2D maximum overflow = {}", overflow_max);
+    });
+    for (int m : chunk_max) {
+        overflow_max = std::max(overflow_max, m);
+    }
+    SPDLOG_TRACE(log_sp, "2D maximum overflow = {}", overflow_max);
 
     if (overflow_max % max_zz) {
         overflow_max = ((overflow_max / max_zz) * 2) + 2;
@@ -181,19 +425,17 @@ void Congestion::init_2d_map(const RoutingRegion& rr_map) {
 #endif
     const EdgePlane3d<int>& routingSpace = rr_map.getMaxCapacity();
 
-    for (int x = 0; x < routingSpace.getXSize(); ++x) {
+    pool.parallel_for("init 2d map", routingSpace.getXSize(), [&](int x, int) {
         for (int y = 0; y < routingSpace.getYSize(); ++y) {
             NTHUR::Coordinate_2d c2 = Coordinate_2d { x, y };
             for (int z = 0; z < routingSpace.getZSize(); ++z) {
                 congestionMap2d.east(c2).max_cap += routingSpace.east(Coordinate_3d { x, y, z });
                 congestionMap2d.south(c2).max_cap += routingSpace.south(Coordinate_3d { x, y, z });
             }
+            congestionMap2d.east(c2).max_cap /= divisor;
+            congestionMap2d.south(c2).max_cap /= divisor;
         }
-    }
-    for (Edge_2d& edge : congestionMap2d.all()) {
-        edge.max_cap /= divisor;
-
-    }
+    });
 
 }
 
@@ -201,24 +443,69 @@ void Congestion::init_2d_map(const RoutingRegion& rr_map) {
 //So if demand value = wire length, this function can be used
 int Congestion::cal_total_wirelength() const {
     int total_wl = 0;
-    for (const Edge_2d& edge : congestionMap2d.all()) {
-        total_wl += (int) edge.cur_cap;
-
+    std::vector<int> chunk_wl(edge_chunks(), 0);
+    sweep_edges("total wirelength", [&](int chunk, int first, int last) {
+        const Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e = first; e < last; ++e) {
+            chunk_wl[chunk] += (int) edges[e].cur_cap;
+        }
+    });
+    for (int wl : chunk_wl) {
+        total_wl += wl;
     }
 
     log_sp->info("total wire length: {}", total_wl);
     return total_wl;
 }
 
+//Number the 2-pin nets by their position in the list, and index them by the edges of their paths.
+//The paths of the list must be the content of the map.
+void Congestion::index_two_pins(std::vector<Two_pin_element_2d>& two_pin_list) {
+    edge_two_pins.resize(congestionMap2d.num_elements());
+    for (std::vector<int>& two_pins : edge_two_pins) {
+        two_pins.clear();
+    }
+    const Edge_2d* edges = congestionMap2d.all().begin();
+    for (int id = 0; id < (int) two_pin_list.size(); ++id) {
+        Two_pin_element_2d& element = two_pin_list[id];
+        element.id = id;
+        for (int i = element.path.size() - 2; i >= 0; --i) {
+            edge_two_pins[&congestionMap2d.edge(element.path[i], element.path[i + 1]) - edges].push_back(id);
+        }
+    }
+    two_pins_indexed = true;
+}
+
 Congestion::Statistic Congestion::stat_congestion() {
     Statistic s;
     s.max = std::numeric_limits<double>::max();
     s.min = std::numeric_limits<double>::min();
     s.avg = 0;
 
-    for (Edge_2d& edge : congestionMap2d.all()) {
-        double edgeCongestion = edge.congestion();
-        if (edgeCongestion > 1.0) {
+//the congested edges are few, they are gathered by chunk and summed up in order.
+//They are the overflowed edges, already known when the totals are valid.
+    std::vector<std::vector<double> > chunk_congestion(edge_chunks());
+    if (totals_valid) {
+        const Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e : sort_overflowed_edges()) {
+            double edgeCongestion = edges[e].congestion();
+            if (edgeCongestion > 1.0) {
+                chunk_congestion[0].push_back(edgeCongestion);
+            }
+        }
+    } else {
+        sweep_edges("congestion statistic", [&](int chunk, int first, int last) {
+            const Edge_2d* edges = congestionMap2d.all().begin();
+            for (int e = first; e < last; ++e) {
+                double edgeCongestion = edges[e].congestion();
+                if (edgeCongestion > 1.0) {
+                    chunk_congestion[chunk].push_back(edgeCongestion);
+                }
+            }
+        });
+    }
+    for (const std::vector<double>& congestions : chunk_congestion) {
+        for (double edgeCongestion : congestions) {
             s.min = std::min(edgeCongestion, s.min);
             s.max = std::max(edgeCongestion, s.max);
             s.avg += edgeCongestion;
@@ -232,45 +519,81 @@ Congestion::Statistic Congestion::stat_congestion() {
 //Add the path of two pin element on to congestion map
 //The congestion map record not only which net pass which edge,
 //but also the number of a net pass through
+template<class Policy>
 void Congestion::update_congestion_map_insert_two_pin_net(Two_pin_element_2d& element) {
 
     for (int i = element.path.size() - 2; i >= 0; --i) {
 //get an edge from congestion map - c_map_2d
 
         Edge_2d& edge = congestionMap2d.edge(element.path[i], element.path[i + 1]);
-        std::pair<RoutedNetTable::iterator, bool> insert_result = edge.used_net.insert(std::pair<const int, int>(element.net_id, 1));
-
-        if (!insert_result.second)
-            ++((insert_result.first)->second);
-        else {
-            ++edge.cur_cap;
-
-            if (used_cost_flag != FASTROUTE_COST) {
-                pre_evaluate_congestion_cost_fp(edge);
+        bool inserted;
+        {
+            //the net table, the usage and the cost of the edge change together
+            typename Policy::Guard guard(edgeLocks, &edge);
+            std::pair<RoutedNetTable::iterator, bool> insert_result = edge.used_net.insert(std::pair<const int, int>(element.net_id, 1));
+
+            inserted = insert_result.second;
+            if (two_pins_indexed && element.id >= 0) {
+                edge_two_pins[&edge - congestionMap2d.all().begin()].push_back(element.id);
             }
+            if (!inserted)
+                ++((insert_result.first)->second);
+            else {
+                ++edge.cur_cap;
+                update_totals(edge, edge.cur_cap - 1);
+                if (used_cost_flag != FASTROUTE_COST) {
+                    pre_evaluate_congestion_cost_fp(edge);
+                }
+            }
+        }
+        if (inserted && coarseGrid) {
+            coarseGrid->update<Policy>(element.path[i], element.path[i + 1], 1.);
         }
     }
 }
 
 //Remove a net from an edge.
 //If the net pass that edge more than once, this function will only decrease the counter.
-void Congestion::update_congestion_map_remove_two_pin_net(const std::vector<Coordinate_2d>& path, const int net_id) {
+template<class Policy>
+void Congestion::update_congestion_map_remove_two_pin_net(const std::vector<Coordinate_2d>& path, const int net_id, const int two_pin_id) {
 
     for (int i = path.size() - 2; i >= 0; --i) {
         Edge_2d& edge = congestionMap2d.edge(path[i], path[i + 1]);
-        RoutedNetTable::iterator find_result = edge.used_net.find(net_id);
+        bool erased = false;
+        {
+            typename Policy::Guard guard(edgeLocks, &edge);
+            RoutedNetTable::iterator find_result = edge.used_net.find(net_id);
+            if (two_pins_indexed && two_pin_id >= 0) {
+                std::vector<int>& two_pins = edge_two_pins[&edge - congestionMap2d.all().begin()];
+                std::vector<int>::iterator pass = std::find(two_pins.begin(), two_pins.end(), two_pin_id);
+                if (pass != two_pins.end()) {
+                    *pass = two_pins.back();
+                    two_pins.pop_back();
+                }
+            }
 
-        --(find_result->second);
-        if (find_result->second == 0) {
-            edge.used_net.erase(net_id);
-            --(edge.cur_cap);
-            if (used_cost_flag != FASTROUTE_COST) {
-                pre_evaluate_congestion_cost_fp(edge);
+            --(find_result->second);
+            if (find_result->second == 0) {
+                erased = true;
+                edge.used_net.erase(find_result);
+                --(edge.cur_cap);
+                update_totals(edge, edge.cur_cap + 1);
+                if (used_cost_flag != FASTROUTE_COST) {
+                    pre_evaluate_congestion_cost_fp(edge);
+                }
             }
         }
+        if (erased && coarseGrid) {
+            coarseGrid->update<Policy>(path[i], path[i + 1], -1.);
+        }
     }
 }
 
+template void Congestion::update_congestion_map_insert_two_pin_net<SerialPolicy>(Two_pin_element_2d& element);
+template void Congestion::update_congestion_map_insert_two_pin_net<ConcurrentPolicy>(Two_pin_element_2d& element);
+template void Congestion::update_congestion_map_remove_two_pin_net<SerialPolicy>(const std::vector<Coordinate_2d>& path, const int net_id, const int two_pin_id);
+template void Congestion::update_congestion_map_remove_two_pin_net<ConcurrentPolicy>(const std::vector<Coordinate_2d>& path, const int net_id, const int two_pin_id);
+
 std::string Congestion::plotCongestionNet(int net_id) const {
     std::string s;
     for (int x = 0; x < congestionMap2d.getXSize(); ++x) {
@@ -301,15 +624,36 @@ void Congestion::calculate_cap() const {
 
     int overflow = 0;
     int max = 0;
-    for (const Edge_2d& edge : congestionMap2d.all()) {
-        if (edge.isOverflow()) {
-            overflow += (edge.overUsage() * 2);
-            if (max < edge.overUsage() * 2)
-                max = edge.overUsage() * 2;
+    std::vector<int> chunk_overflow(edge_chunks(), 0);
+    std::vector<int> chunk_max(edge_chunks(), 0);
+    sweep_edges("overflow sum", [&](int chunk, int first, int last) {
+        const Edge_2d* edges = congestionMap2d.all().begin();
+        for (int e = first; e < last; ++e) {
+            const Edge_2d& edge = edges[e];
+            if (edge.isOverflow()) {
+                chunk_overflow[chunk] += (edge.overUsage() * 2);
+                if (chunk_max[chunk] < edge.overUsage() * 2)
+                    chunk_max[chunk] = edge.overUsage() * 2;
+            }
         }
+    });
+    for (int chunk = 0; chunk < edge_chunks(); ++chunk) {
+        overflow += chunk_overflow[chunk];
+        max = std::max(max, chunk_max[chunk]);
     }
     log_sp->info("2D sum overflow = {}", overflow); //
     log_sp->info("2D max overflow = {}", max);
 }
 
+int Congestion::edge_chunks() const {
+    return (congestionMap2d.num_elements() + EDGE_CHUNK - 1) / EDGE_CHUNK;
+}
+
+void Congestion::sweep_edges(const std::string& name, const std::function<void(int chunk, int first, int last)>& f) const {
+    const int edges = congestionMap2d.num_elements();
+    pool.parallel_for(name, edge_chunks(), [&](int chunk, int) {
+        f(chunk, chunk * EDGE_CHUNK, std::min(edges, (chunk + 1) * EDGE_CHUNK));
+    });
+}
+
 } // namespace NTHUR
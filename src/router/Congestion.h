@@ -8,19 +8,25 @@
 #ifndef SRC_ROUTER_CONGESTION_H_
 #define SRC_ROUTER_CONGESTION_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include "../grdb/EdgePlane.h"
 #include "../misc/geometry.h"
+#include "../misc/StripedLock.h"
 #include "DataDef.h"
 
 namespace spdlog {
 class logger;
 } /* namespace spdlog */
 namespace NTHUR {
+class CoarseGrid;
 class RoutingRegion;
+class ThreadPool;
 
 class Congestion {
 public:
@@ -40,23 +46,77 @@ public:
     double WL_Cost;
     double factor;
     int cur_iter;
+    double cost_base;                           //part of the edge costs shared by all the edges, see edge_cost()
     EdgePlane<Edge_2d> congestionMap2d;
+    std::unique_ptr<CoarseGrid> coarseGrid;     //optional coarse view kept in sync with congestionMap2d
+    StripedLock edgeLocks;                      //guards the edges of congestionMap2d in ConcurrentPolicy updates
+    ThreadPool& pool;                           //sweeps the whole map
+    //Totals of the map, rebuilt by cal_max_overflow() then kept up to date by the 2-pin net
+    //updates. Any other change of cur_cap must be followed by cal_max_overflow().
+    std::atomic<int> total_overflow;            //sum of overUsage() on the overflowed edges
+    std::atomic<int> total_wirelength;          //sum of (int) cur_cap
+    std::vector<std::atomic<int> > overflow_histogram;  //overflowed edges by overUsage(), the last bucket holds the larger ones
+    std::vector<int> overflowed_edges;          //positions in congestionMap2d.all() of the overflowed edges, unordered
+    std::vector<int> overflowed_slot;           //index in overflowed_edges of every edge, -1 if not overflowed
+    std::mutex overflowed_mutex;                //guards overflowed_edges and overflowed_slot in every update
+    bool totals_valid;
+    //Edge costs of the cost function cost_flag_evaluated, refreshed by pre_evaluate_congestion_cost().
+    //Only the cost of an edge with history > 1 depends on cur_iter and factor, the other ones
+    //are refreshed by the 2-pin net updates. A change of used_cost_flag needs a full refresh.
+    int cost_flag_evaluated;
+    std::vector<int> history_edges;             //positions in congestionMap2d.all() of the edges with history > 1
+    //Ids of the 2-pin nets passing every edge, once per pass, by position in congestionMap2d.all().
+    //Built by index_two_pins(), then kept up to date by the 2-pin net updates while two_pins_indexed.
+    std::vector<std::vector<int> > edge_two_pins;
+    bool two_pins_indexed;
     std::shared_ptr<spdlog::logger> log_sp;
-    Congestion(int x, int y);
+    Congestion(int x, int y, ThreadPool& pool);
+    ~Congestion();
 
+    ///@brief Cost of an edge not passed by the net yet: the cached edge part plus cost_base
+    double edge_cost(const Edge_2d& edge) const {
+        return cost_base + edge.cost;
+    }
     double get_cost_2d(const Coordinate_2d& c1, const Coordinate_2d& c2, int net_id, int& distance);
     int cal_max_overflow();
+    int report_max_overflow();
+    int report_total_wirelength();
+    ///@brief overflowed_edges sorted in the order of congestionMap2d.all(), for the loops depending on the order
+    const std::vector<int>& sort_overflowed_edges();
     void pre_evaluate_congestion_cost_all(Edge_2d& edge) const;
     void pre_evaluate_congestion_cost();
     bool check_path_no_overflow(const std::vector<Coordinate_2d>&path, const int net_id, const int inc_flag) const;
     int find_overflow_max(int max_zz) const;
     void init_2d_map(const RoutingRegion& rr_map);
     int cal_total_wirelength() const;
+    void index_two_pins(std::vector<Two_pin_element_2d>& two_pin_list);
     Statistic stat_congestion();
+    ///@brief Add a 2-pin net path to the map.
+    ///@details With ConcurrentPolicy, paths of different nets can be added and removed
+    ///         concurrently, as long as nothing else reads the map meanwhile.
+    template<class Policy = SerialPolicy>
     void update_congestion_map_insert_two_pin_net(Two_pin_element_2d& element);
-    void update_congestion_map_remove_two_pin_net(const std::vector<Coordinate_2d>& path, const int net_id);
+    ///@brief Remove a 2-pin net path from the map, two_pin_id being the id of its 2-pin net if it has one.
+    template<class Policy = SerialPolicy>
+    void update_congestion_map_remove_two_pin_net(const std::vector<Coordinate_2d>& path, const int net_id, const int two_pin_id = -1);
     void calculate_cap() const;
     std::string plotCongestionNet(int net_id) const;
+
+    ///@brief Number of chunks of consecutive edges of congestionMap2d.all() swept by sweep_edges()
+    int edge_chunks() const;
+    ///@brief Run f(chunk, first, last) on every chunk of edges [first, last) concurrently.
+    ///@details The loops keep one partial result per chunk and merge them in chunk order,
+    ///         so that the results do not depend on the thread count.
+    void sweep_edges(const std::string& name, const std::function<void(int chunk, int first, int last)>& f) const;
+
+private:
+    void scan_overflow(bool refresh_cost, int& overflow, int& max, int& wirelength);
+    int histogram_bucket(int overUsage) const;
+    int histogram_max() const;
+    void update_totals(const Edge_2d& edge, double before);
+    void check_totals();
+    void check_costs();
+    void refresh_cost_base();
 };
 
 } // namespace NTHUR
@@ -17,12 +17,17 @@
 #include "flute4nthuroute.h"
 #include "../grdb/RoutingComponent.h"
 #include "../grdb/RoutingRegion.h"
+#include "../misc/ThreadPool.h"
 //#define SPDLOG_TRACE_ON
 #include "../spdlog/details/logger_impl.h"
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
 #include "../spdlog/spdlog.h"
+#include "CoarseGrid.h"
+#include "Checkpoint.h"
 #include "Congestion.h"
+#include "EcoRouting.h"
+#include "IterationControl.h"
 #include "Route_2pinnets.h"
 
 namespace NTHUR {
@@ -56,6 +61,7 @@ void Construct_2d_tree::init_2pin_list() {
 
 void Construct_2d_tree::init_flute() {
     net_flutetree.resize(rr_map.get_netNumber());
+    net_tree.resize(rr_map.get_netNumber());
 }
 
 void Construct_2d_tree::bbox_route(Two_pin_list_2d& list, const double value) {
@@ -116,7 +122,8 @@ void Construct_2d_tree::walkL(const Coordinate_2d& a, const Coordinate_2d& b, st
  input: start coordinate and end coordinate, and directions of L
  output: record the best L pattern into two_pin_L_path_global, and return the min max congestion value
  */
-Monotonic_element Construct_2d_tree::L_pattern_max_cong(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id) {
+Monotonic_element Construct_2d_tree::L_pattern_max_cong(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id,
+        const EdgePlane<int>* netEdges) {
 
     int distance;
 
@@ -128,7 +135,12 @@ Monotonic_element Construct_2d_tree::L_pattern_max_cong(const Coordinate_2d& c1,
     max_path.via_num = 1;
 
     walkL(c1, c2, [&](const Coordinate_2d& a,const Coordinate_2d& b) {
-        double temp = congestion.get_cost_2d(a,b, net_id, distance);
+        double temp = 0;
+        distance = 0;
+        //an edge marked in netEdges is passed by the net, as if lookupNet(net_id) was true
+        if (netEdges == nullptr || netEdges->edge(a, b) != net_id) {
+            temp = congestion.get_cost_2d(a,b, net_id, distance);
+        }
         max_path.total_cost += max(static_cast<double>(0), temp);
         max_path.distance += distance;
         two_pin_L_path.path.push_back(a);
@@ -145,16 +157,17 @@ Monotonic_element Construct_2d_tree::L_pattern_max_cong(const Coordinate_2d& c1,
  output: record the L_pattern in the path, and the path is min max congestioned
  */
 
-void Construct_2d_tree::L_pattern_route(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id) {
+void Construct_2d_tree::L_pattern_route(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id,
+        const EdgePlane<int>* netEdges) {
     Two_pin_element_2d path1;
     Monotonic_element max_cong_path1;
 
-    max_cong_path1 = L_pattern_max_cong(c1, c2, path1, net_id);
+    max_cong_path1 = L_pattern_max_cong(c1, c2, path1, net_id, netEdges);
 
     if (!c1.isAligned(c2)) {
         Two_pin_element_2d path2;
         Monotonic_element max_cong_path2;
-        max_cong_path2 = L_pattern_max_cong(c2, c1, path2, net_id);
+        max_cong_path2 = L_pattern_max_cong(c2, c1, path2, net_id, netEdges);
         if (max_cong_path1 < max_cong_path2) {
             two_pin_L_path = path1;
         } else {
@@ -169,8 +182,33 @@ void Construct_2d_tree::L_pattern_route(const Coordinate_2d& c1, const Coordinat
     two_pin_L_path.net_id = net_id;
 }
 
+/*
+ input: a net and its tree
+ output: the L-shaped routes of the branches, chosen without inserting them. The edges
+ of the routes already chosen are marked with the net id in netEdges, so that the
+ following branches see them as passed by the net, as after an insertion.
+ */
+void Construct_2d_tree::L_pattern_route_tree(const TreeFlute& tree, int netId, EdgePlane<int>& netEdges, std::vector<Two_pin_element_2d>& L_paths) {
+    for (int k = 0; k < tree.number; ++k) {
+
+        const Branch& branch = tree.branch[k];
+        Coordinate_2d c1 { (int) branch.x, (int) branch.y };
+        Coordinate_2d c2 { (int) tree.branch[branch.n].x, (int) tree.branch[branch.n].y };
+        SPDLOG_TRACE(log_sp, "branch k:{} c1:{} c2:{}", k, c1.toString(), c2.toString());
+        if (c1 != c2) {
+            /*choose the L-shape with lower congestion to assign new demand 1*/
+            L_paths.emplace_back();
+            Two_pin_element_2d& L_path = L_paths.back();
+            L_pattern_route(c1, c2, L_path, netId, &netEdges);
+            for (std::size_t i = 1; i < L_path.path.size(); ++i) {
+                netEdges.edge(L_path.path[i - 1], L_path.path[i]) = netId;
+            }
+        }
+    }
+}
+
 //generate the congestion map by Flute with wirelength driven mode
-void Construct_2d_tree::gen_FR_congestion_map() {
+void Construct_2d_tree::gen_FR_congestion_map(const RoutingParameters& routingparam, const EcoRouting* eco) {
     //a struct, defined by Flute library
 
     for (int& i : bboxRouteStateMap.all()) {
@@ -182,23 +220,57 @@ void Construct_2d_tree::gen_FR_congestion_map() {
     SPDLOG_TRACE(log_sp, "initial the information of pin's coordinate and group by net for flute");
     init_flute();
 
+//In ECO mode, the nets keeping their previous routing are inserted first,
+//and only the other ones are routed, on top of them.
+    std::vector<int> nets;
+    nets.reserve(rr_map.get_netNumber());
+    for (uint32_t i = 0; i < rr_map.get_netNumber(); ++i) {
+        if (eco != nullptr && eco->kept(i)) {
+            for (Two_pin_element_2d& path : eco->paths_2d(i)) {
+                net_2pin_list[i].push_back(std::move(path));
+                congestion.update_congestion_map_insert_two_pin_net(net_2pin_list[i].back());
+            }
+        } else {
+            nets.push_back(i);
+        }
+    }
+
     /*assign 0.5 demand to each net*/
 
     SPDLOG_TRACE(log_sp, "bbox routing start... ");
 
 //for storing the RSMT which returned by flute
-    Flute netRoutingTreeRouter;
+    Flute netRoutingTreeRouter(routingparam.get_flute_cache_file());
+    if (routingparam.get_flute_check_nets() > 0) {
+        int mismatches = Flute::check_low_degree_trees(routingparam.get_flute_check_nets(), 1);
+        if (mismatches > 0) {
+            log_sp->error("{} trees of 2 or 3 pin nets differ from FLUTE", mismatches);
+        } else {
+            log_sp->info("{} trees of 2 or 3 pin nets checked", routingparam.get_flute_check_nets());
+        }
+    }
     std::vector<TreeFlute> flutetree(rr_map.get_netNumber());
 
+//Every worker counts the bounding box demand of its nets in its own map, an edge
+//being counted once per net (lastNet), and the maps are summed up afterwards.
+//The demands are integers, so the sum does not depend on the split of the nets.
+    std::vector<EdgePlane<int> > bboxDemand(pool.size(), EdgePlane<int>(rr_map.get_gridx(), rr_map.get_gridy()));
+    std::vector<EdgePlane<int> > lastNet(pool.size(), EdgePlane<int>(rr_map.get_gridx(), rr_map.get_gridy()));
+    for (EdgePlane<int>& netMap : lastNet) {
+        for (int& i : netMap.all()) {
+            i = -1;
+        }
+    }
+
 //Get every net's possible RSMT by flute, then use it to calculate the possible congestion
 //In this section, we won't get a real routing result, but a possible congestion information.
-    for (uint32_t i = 0; i < rr_map.get_netNumber(); ++i) {	//i:net id
+    pool.parallel_for("flute", nets.size(), [&](int n, int worker) {
+        int i = nets[n];	//i:net id
         SPDLOG_TRACE(log_sp, "bbox route net {} start...pin_num={}", i, rr_map.get_netPinNumber(i));
 
 //call flute to gen steiner tree and put the result in flutetree[]
         TreeFlute& tree = flutetree[i];
         netRoutingTreeRouter.routeNet(rr_map.get_net(i).get_pinList(), tree);	//
-        SPDLOG_TRACE(log_sp, "rr_map.nPinList(i): {}", rr_map.nPinToString(i));
 //The total node # in a tree, those nodes include pin and steiner point
 //And it is defined as ((2 * degree of a tree) - 2) by the authors of flute
         tree.number = 2 * tree.deg - 2;	//add 0403
@@ -215,61 +287,99 @@ void Construct_2d_tree::gen_FR_congestion_map() {
             two_pin.pin2.y = (int) tree.branch[branch.n].y;
             two_pin.net_id = i;
 
-            SPDLOG_TRACE(log_sp, "two_pin {}", two_pin.toString());
-
             if (two_pin.pin1 != two_pin.pin2) {
                 bbox_2pin_list[i].push_back(std::move(two_pin));
-                SPDLOG_TRACE(log_sp, "bbox_2pin_list[i].push_back {}", j);
             }
+        }
 
+//same edges as bbox_route(bbox_2pin_list[i], 0.5)
+        EdgePlane<int>& demand = bboxDemand[worker];
+        EdgePlane<int>& netMap = lastNet[worker];
+        for (Two_pin_element_2d& it : bbox_2pin_list[i]) {
+            Rectangle rect {it.pin1.x, it.pin2};
+            rect.frame([&](const Coordinate_2d& c1,const Coordinate_2d& c2) {
+                int& last = netMap.edge(c1, c2);
+                if (last != i) {
+                    last = i;
+                    ++demand.edge(c1, c2);
+                }
+            });
         }
+    });
 
-        bbox_route(bbox_2pin_list[i], 0.5);
-    }	//
+    log_sp->info("{}", netRoutingTreeRouter.cacheStatistics());
+    netRoutingTreeRouter.save_cache();
+
+    const int edges = congestion.congestionMap2d.num_elements();
+    const int chunk = 4096;
+    pool.parallel_for("bbox demand", (edges + chunk - 1) / chunk, [&](int c, int) {
+        Edge_2d* edge = congestion.congestionMap2d.all().begin();
+        for (int e = c * chunk; e < std::min(edges, (c + 1) * chunk); ++e) {
+            int sum = 0;
+            for (const EdgePlane<int>& demand : bboxDemand) {
+                sum += demand.all().begin()[e];
+            }
+            edge[e].cur_cap += sum;
+        }
+    });
     SPDLOG_TRACE(log_sp, "bbox routing complete");	//
     SPDLOG_TRACE(log_sp, "L-shaped pattern routing start...");
 
 //sort net by their bounding box size, then by their pin number
     vector<const Net*> sort_net;
-    for (uint32_t i = 0; i < rr_map.get_netNumber(); ++i) {
+    for (int i : nets) {
         sort_net.push_back(&rr_map.get_net(i));
     }
     sort(sort_net.begin(), sort_net.end(), [&]( const Net* a, const Net* b ) {return Net::comp_net(*a,*b);});
 
 //Now begins the initial routing by pattern routing
 //Edge shifting will also be applied to the routing.
-    for (const Net* it : sort_net) {
-        int netId = it->id;
-        TreeFlute& ftreeId = flutetree[netId];
-        edge_shifting(ftreeId, netId);
-
-        net_flutetree[netId] = ftreeId;
+//The nets are taken by batches. The nets of a batch are edge shifted concurrently on
+//the congestion left by the previous batches, their bounding box demand is removed,
+//their L-shaped routes are chosen concurrently, and the routes are inserted in order.
+//Batches of one net give the serial result. The lastNet maps now mark the edges
+//taken by the branches of a net before they are inserted.
+//The serial routing is the default: the batches route on older congestion and add overflow.
+    for (EdgePlane<int>& netMap : lastNet) {
+        for (int& i : netMap.all()) {
+            i = -1;
+        }
+    }
+    const std::size_t batch = std::max(1, routingparam.get_p1_batch());
+    std::vector<std::vector<Two_pin_element_2d> > L_paths(batch);
+    for (std::size_t first = 0; first < sort_net.size(); first += batch) {
+        const std::size_t last = std::min(sort_net.size(), first + batch);
+        pool.parallel_for("edge shifting", last - first, [&](int i, int) {
+            int netId = sort_net[first + i]->id;
+            edge_shifting(flutetree[netId], netId);
+        });
 
-        /*remove demand*/
-        bbox_route(bbox_2pin_list[netId], -0.5);
+        for (std::size_t i = first; i < last; ++i) {
+            int netId = sort_net[i]->id;
+            net_flutetree[netId] = std::move(flutetree[netId]);
 
-        for (int k = 0; k < ftreeId.number; ++k) {
+            /*remove demand*/
+            bbox_route(bbox_2pin_list[netId], -0.5);
+        }
 
-            Branch& branch = ftreeId.branch[k];
-            Coordinate_2d c1 { (int) branch.x, (int) branch.y };
-            Coordinate_2d c2 { (int) ftreeId.branch[branch.n].x, (int) ftreeId.branch[branch.n].y };
-            SPDLOG_TRACE(log_sp, "branch k:{} c1:{} c2:{}", k, c1.toString(), c2.toString());
-            if (c1 != c2) {
-                /*choose the L-shape with lower congestion to assign new demand 1*/
-                Two_pin_element_2d L_path;
-                L_pattern_route(c1, c2, L_path, netId);
+        pool.parallel_for("L-shaped routing", last - first, [&](int i, int worker) {
+            int netId = sort_net[first + i]->id;
+            L_paths[i].clear();
+            L_pattern_route_tree(net_flutetree[netId], netId, lastNet[worker], L_paths[i]);
+        });
 
+        for (std::size_t i = first; i < last; ++i) {
+            for (Two_pin_element_2d& L_path : L_paths[i - first]) {
                 /*insert 2pin_path into this net*/
-                net_2pin_list[netId].push_back(L_path);
+                net_2pin_list[L_path.net_id].push_back(L_path);
                 NetDirtyBit[L_path.net_id] = true;
                 congestion.update_congestion_map_insert_two_pin_net(L_path);
                 SPDLOG_TRACE(log_sp, "L_path {}", L_path.toString());
-
             }
         }
-
     }
 
+
     SPDLOG_TRACE(log_sp, "generate L-shape congestion map in stage1 successfully ");
 
     congestion.cal_max_overflow();
@@ -673,14 +783,20 @@ void Construct_2d_tree::output_2_pin_list() {
  return max_overflow;
  */
 
-Construct_2d_tree::Construct_2d_tree(const RoutingParameters& routingparam,const RoutingRegion& rr, Congestion& congestion) :
+Construct_2d_tree::Construct_2d_tree(const RoutingParameters& routingparam,const RoutingRegion& rr, Congestion& congestion, ThreadPool& pool,
+        const EcoRouting* eco) :
 
         bboxRouteStateMap { rr.get_gridx(), rr.get_gridy() }, //
         rr_map { rr }, //
+        control { routingparam.get_stall_rate_p2(), routingparam.get_stall_window_p2(), routingparam.get_stall_escalations_p2() }, //
         congestion { congestion }, //
+        pool { pool }, //
         mazeroute_in_range { *this, congestion }, //
-        rangeRouter { *this, congestion, true }, //
-        post_processing { routingparam, congestion, *this, rangeRouter }  //
+        rangeRouter { *this, congestion, true, routingparam.get_wavefront_max_cells() }, //
+        post_processing { routingparam, congestion, *this, rangeRouter }, //
+        eco { eco }, //
+        deadline { routingparam.get_deadline() }, //
+        best_overflow { INT_MAX }  //
 {
     log_sp = spdlog::get("NTHUR");
     /***********************
@@ -688,70 +804,180 @@ Construct_2d_tree::Construct_2d_tree(const RoutingParameters& routingparam,const
      * ********************/
 
     /* TroyLee: NetDirtyBit Counter */
-    NetDirtyBit = vector<bool>(rr_map.get_netNumber(), true);
+    NetDirtyBit = vector<char>(rr_map.get_netNumber(), true);
     /* TroyLee: End */
 
-    log_sp->info("gen_FR_congestion_map ");
-    gen_FR_congestion_map();        // Generate congestion map by flute, then route all nets by L-shap pattern routing with
+    Checkpoint checkpoint(routingparam.get_checkpoint_file(), routingparam.get_checkpoint_interval());
+    Checkpoint::Position position { Checkpoint::MAIN, 1 };
+    const bool resume = !routingparam.get_resume_file().empty();
+    if (resume) {
+        congestion.init_2d_map(rr_map);
+        init_flute();
+        if (routingparam.get_coarse_tile_size() > 1) {
+            congestion.coarseGrid.reset(new CoarseGrid(congestion.congestionMap2d, routingparam.get_coarse_tile_size(), routingparam.get_coarse_min_span()));
+        }
+        position = Checkpoint::load(routingparam.get_resume_file(), *this);
+        congestion.used_cost_flag = position.stage == Checkpoint::MAIN ? HISTORY_COST : MADEOF_COST;
+        congestion.cal_max_overflow();
+        //the next pre_evaluate_congestion_cost() refreshes every cost and indexes the edges with history > 1
+        congestion.cost_flag_evaluated = -1;
+    } else {
+        log_sp->info("gen_FR_congestion_map ");
+        gen_FR_congestion_map(routingparam, eco);        // Generate congestion map by flute, then route all nets by L-shap pattern routing with
 // congestion information from this map. After that, apply edge shifting to the result
 // to get the initial solution.
-    log_sp->info(" congestion.cal_total_wirelength();");
-    congestion.cal_total_wirelength();        // The report value is the sum of demand on every edge
-    congestion.cal_max_overflow();
+        log_sp->info(" congestion.cal_total_wirelength();");
+        congestion.cal_total_wirelength();        // The report value is the sum of demand on every edge
+        congestion.cal_max_overflow();
+    }
     Route_2pinnets route_2pinnets(*this, rangeRouter, congestion);
 
     route_2pinnets.allocate_gridcell();        //question: I don't know what this for. (jalamorm, 07/10/31)
 
+    if (!resume) {
 //Make a 2-pin net list without group by net
-    for (Two_pin_list_2d& netList : net_2pin_list) {
-        for (Two_pin_element_2d& ele : netList) {
-            two_pin_list.push_back(ele);
+        for (Two_pin_list_2d& netList : net_2pin_list) {
+            for (Two_pin_element_2d& ele : netList) {
+                two_pin_list.push_back(ele);
+            }
         }
-    }
 
-    route_2pinnets.reallocate_two_pin_list();
+        route_2pinnets.reallocate_two_pin_list();
+        BOXSIZE_INC = routingparam.get_init_box_size_p2();
+    }
 
     congestion.used_cost_flag = HISTORY_COST;
-    BOXSIZE_INC = routingparam.get_init_box_size_p2();
 
-    for (congestion.cur_iter = 1, done_iter = congestion.cur_iter; congestion.cur_iter <= routingparam.get_iteration_p2(); ++congestion.cur_iter, done_iter = congestion.cur_iter) //do n-1 times
-            {
+    if (routingparam.get_coarse_tile_size() > 1 && !congestion.coarseGrid) {
+        congestion.coarseGrid.reset(new CoarseGrid(congestion.congestionMap2d, routingparam.get_coarse_tile_size(), routingparam.get_coarse_min_span()));
+    }
+    if (pool.size() > 1 || routingparam.get_reroute_batch() > 0) {
+        rangeRouter.enable_parallel(pool, routingparam.get_reroute_batch(), routingparam.get_deterministic());
+    }
 
-        log_sp->info("Iteration: {} ", congestion.cur_iter);
+    if (!resume) {
+        control.start(congestion.total_overflow);
+    }
+    keep_best(congestion.total_overflow);
+    bool eco_stop = eco != nullptr && congestion.total_overflow == 0;
+    if (eco_stop) {
+        log_sp->info("ECO: no overflow, the routing is kept");
+    }
+    if (position.stage == Checkpoint::MAIN) {
+        for (congestion.cur_iter = position.iteration, done_iter = congestion.cur_iter; !eco_stop && congestion.cur_iter <= routingparam.get_iteration_p2(); ++congestion.cur_iter, done_iter = congestion.cur_iter) //do n-1 times
+                {
+            checkpoint.save(congestion.cur_iter - 1, Checkpoint::Position { Checkpoint::MAIN, congestion.cur_iter }, *this);
 
-        congestion.factor = (1.0 - std::exp(-5 * std::exp(-(0.1 * congestion.cur_iter))));
+            log_sp->info("Iteration: {} ", congestion.cur_iter);
 
-        congestion.WL_Cost = congestion.factor;
-        congestion.via_cost = static_cast<int>(4 * congestion.factor);
+            congestion.factor = (1.0 - std::exp(-5 * std::exp(-(0.1 * congestion.cur_iter))));
 
-        SPDLOG_TRACE(log_sp, "Parameters - Factor: {}, Via_Cost: {}, Box Size: {}",   //
-                congestion.factor, congestion.via_cost, BOXSIZE_INC + congestion.cur_iter - 1);
+            congestion.WL_Cost = congestion.factor;
+            congestion.via_cost = static_cast<int>(4 * congestion.factor);
 
-        congestion.pre_evaluate_congestion_cost();
+            SPDLOG_TRACE(log_sp, "Parameters - Factor: {}, Via_Cost: {}, Box Size: {}",   //
+                    congestion.factor, congestion.via_cost, BOXSIZE_INC + congestion.cur_iter - 1);
 
-        route_2pinnets.route_all_2pin_net();
+            congestion.pre_evaluate_congestion_cost();
 
-        int cur_overflow = congestion.cal_max_overflow();
-        congestion.cal_total_wirelength();
+            if (eco != nullptr) {
+                limit_to_eco_scope();
+            }
+            route_2pinnets.route_all_2pin_net();
 
-        if (cur_overflow == 0) {
-            log_sp->info("No more overflow =0");
-            break;
-        }
+            int cur_overflow = congestion.report_max_overflow();
+            congestion.report_total_wirelength();
 
-        route_2pinnets.reallocate_two_pin_list();
+            if (cur_overflow == 0) {
+                log_sp->info("No more overflow =0");
+                break;
+            }
+            if (expired()) {
+                log_sp->info("Iteration {}: time limit reached", congestion.cur_iter);
+                break;
+            }
+            if (eco != nullptr && cur_overflow >= best_overflow) {
+                log_sp->info("Iteration {}: ECO overflow {} not below {}, stop", congestion.cur_iter, cur_overflow, best_overflow);
+                eco_stop = true;
+                break;
+            }
+            keep_best(cur_overflow);
 
-        if (cur_overflow <= routingparam.get_overflow_threshold()) {
-            log_sp->info("cur overflow {} <= overflow_threshold {} ", cur_overflow, routingparam.get_overflow_threshold());
-            break;
+            route_2pinnets.reallocate_two_pin_list();
+
+            if (cur_overflow <= routingparam.get_overflow_threshold()) {
+                log_sp->info("cur overflow {} <= overflow_threshold {} ", cur_overflow, routingparam.get_overflow_threshold());
+                break;
+            }
+            IterationControl::Action action = control.next(cur_overflow);
+            if (action == IterationControl::HANDOVER) {
+                log_sp->info("Iteration {}: stalled, hand over to post processing: {}", congestion.cur_iter, control.reason());
+                break;
+            }
+            if (action == IterationControl::ESCALATE) {
+                log_sp->info("Iteration {}: stalled, box expansion escalated to {}: {}", congestion.cur_iter,
+                        control.box_expand(routingparam.get_box_size_inc_p2()), control.reason());
+            }
+            BOXSIZE_INC += control.box_expand(routingparam.get_box_size_inc_p2());
         }
-        BOXSIZE_INC += routingparam.get_box_size_inc_p2();
+        output_2_pin_list();    //order:bbox
     }
 
-    output_2_pin_list();    //order:bbox
+    if (!expired() && !eco_stop) {
+        post_processing.process(route_2pinnets, checkpoint, position);
+    }
+    restore_best(congestion.total_overflow);
+}
+
+//In ECO mode, the rip-up and reroute only takes the new or changed nets, and the nets passing an overflowed edge
+void Construct_2d_tree::limit_to_eco_scope() {
+    std::vector<char>& scope = rangeRouter.scope;
+    scope.assign(rr_map.get_netNumber(), !congestion.totals_valid);
+    if (!congestion.totals_valid) {
+        return;
+    }
+    for (uint32_t i = 0; i < rr_map.get_netNumber(); ++i) {
+        scope[i] = !eco->kept(i);
+    }
+    const Edge_2d* edges = congestion.congestionMap2d.all().begin();
+    for (int e : congestion.overflowed_edges) {
+        for (const auto& net : edges[e].used_net) {
+            scope[net.first] = true;
+        }
+    }
+}
 
-    post_processing.process(route_2pinnets);
+//Keep a copy of the 2-pin nets if the overflow is the lowest so far, when there is a time limit or in ECO mode.
+//It is called at the end of an iteration, when the congestion map holds the paths of two_pin_list.
+void Construct_2d_tree::keep_best(int overflow) {
+    if ((deadline == std::chrono::steady_clock::time_point::max() && eco == nullptr) || overflow >= best_overflow) {
+        return;
+    }
+    best_overflow = overflow;
+    best_two_pin_list = two_pin_list;
+}
 
+//Restore the kept 2-pin nets if their overflow is lower, and rebuild the congestion map from their paths.
+//The coarse grid is dropped: only the layer assignment follows.
+void Construct_2d_tree::restore_best(int overflow) {
+    if (best_overflow >= overflow) {
+        return;
+    }
+    log_sp->info("restore the best solution: overflow {} instead of {}", best_overflow, overflow);
+    congestion.totals_valid = false;
+    congestion.two_pins_indexed = false;
+    congestion.coarseGrid.reset();
+    for (Edge_2d& edge : congestion.congestionMap2d.all()) {
+        edge.used_net.clear();
+        edge.cur_cap = 0;
+    }
+    two_pin_list.swap(best_two_pin_list);
+    best_two_pin_list.clear();
+    for (Two_pin_element_2d& element : two_pin_list) {
+        congestion.update_congestion_map_insert_two_pin_net(element);
+    }
+    congestion.cal_max_overflow();
+    congestion.cal_total_wirelength();
 }
 
 } // namespace NTHUR
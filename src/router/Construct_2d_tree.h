@@ -1,6 +1,7 @@
 #ifndef _CONSTRUCT_2D_TREE_H_
 #define _CONSTRUCT_2D_TREE_H_
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -10,6 +11,7 @@
 #include "../grdb/EdgePlane.h"
 #include "../misc/geometry.h"
 #include "DataDef.h"
+#include "IterationControl.h"
 #include "MM_mazeroute.h"
 #include "parameter.h"
 #include "Post_processing.h"
@@ -21,10 +23,12 @@ class logger;
 
 namespace NTHUR {
 
+class EcoRouting;
 class Monotonic_element;
 
 class Net;
 class ParameterSet;
+class ThreadPool;
 class RoutingParameters;
 class RoutingRegion;
 
@@ -78,10 +82,13 @@ struct Construct_2d_tree {
     int done_iter;
 
     int BOXSIZE_INC;
+    IterationControl control;               //stall watch of the main stage iterations
     std::vector<TreeFlute> net_flutetree;
+    std::vector<NetTree> net_tree;          //maze routing view of net_flutetree, built on demand
 
-    std::vector<bool> NetDirtyBit;
+    std::vector<char> NetDirtyBit;          //not vector<bool>: set concurrently for different nets
     Congestion& congestion;
+    ThreadPool& pool;
     Multisource_multisink_mazeroute mazeroute_in_range;
     RangeRouter rangeRouter;
     Post_processing post_processing;
@@ -94,15 +101,32 @@ struct Construct_2d_tree {
 
     std::shared_ptr<spdlog::logger> log_sp;
 
+    //Time budget of the rip-up and reroute. Until it expires, the lowest overflow
+    //solution seen so far is kept, and it is restored when routing stops.
+    //The ECO mode keeps it too, and stops once an iteration does not lower it.
+    const EcoRouting* eco;
+    std::chrono::steady_clock::time_point deadline;
+    int best_overflow;
+    std::vector<Two_pin_element_2d> best_two_pin_list;
+
+    bool expired() const {
+        return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+    }
+    void keep_best(int overflow);
+    void restore_best(int overflow);
+
     void init_2pin_list();
     void init_flute();
     void bbox_route(Two_pin_list_2d& list, const double value);
 
-    Monotonic_element L_pattern_max_cong(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id);
+    Monotonic_element L_pattern_max_cong(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id,
+            const EdgePlane<int>* netEdges = nullptr);
 
-    void L_pattern_route(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id);
+    void L_pattern_route(const Coordinate_2d& c1, const Coordinate_2d& c2, Two_pin_element_2d& two_pin_L_path, int net_id,
+            const EdgePlane<int>* netEdges = nullptr);
+    void L_pattern_route_tree(const TreeFlute& tree, int netId, EdgePlane<int>& netEdges, std::vector<Two_pin_element_2d>& L_paths);
 
-    void gen_FR_congestion_map();
+    void gen_FR_congestion_map(const RoutingParameters& routingparam, const EcoRouting* eco);
     double compute_L_pattern_cost(const Coordinate_2d& c1, const Coordinate_2d& c2, int net_id);
     void find_saferange(Vertex_flute& a, Vertex_flute& b, int *low, int *high, int dir);
     void merge_vertex(Vertex_flute& keep, Vertex_flute& deleted);
@@ -111,10 +135,13 @@ struct Construct_2d_tree {
     void dfs_output_tree(Vertex_flute& node, int parent, TreeFlute& t);
     void edge_shifting(TreeFlute& t, int i);
     void output_2_pin_list();
-    Construct_2d_tree(const RoutingParameters & routingparam, const RoutingRegion & rr, Congestion& congestion);
+    ///@param eco previous routing kept by the unchanged nets, null to route every net
+    Construct_2d_tree(const RoutingParameters & routingparam, const RoutingRegion & rr, Congestion& congestion, ThreadPool& pool,
+            const EcoRouting* eco = nullptr);
     void walkL(const Coordinate_2d& a, const Coordinate_2d& b, std::function<void(const Coordinate_2d& e1, const Coordinate_2d& e2)> f);
 
 private:
+    void limit_to_eco_scope();
     Vertex_flute_ptr findY(Vertex_flute& a, std::function<bool(const int& i, const int& j)> test);
     Vertex_flute_ptr findX(Vertex_flute& a, std::function<bool(const int& i, const int& j)> test);
     void move_edge_hor(Vertex_flute& a, int best_pos, Vertex_flute& b, Vertex_flute_ptr& overlap_a, std::function<bool(const int& i, const int& j)> test);
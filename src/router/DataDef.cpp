@@ -14,7 +14,7 @@ namespace NTHUR {
 
 
 Edge_2d::Edge_2d() :
-        cost(0.0), MMVisitFlag(-1), cur_cap(0.), max_cap(0.), history(1), used_net(128) {
+        cost(0.0), cur_cap(0.), max_cap(0.), history(1), used_net(128) {
 
 }
 
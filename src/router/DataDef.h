@@ -36,7 +36,7 @@ enum {
 class Two_pin_element_2d {
 public:
     Two_pin_element_2d() :
-            net_id(0), done(-1) {
+            net_id(0), done(-1), id(-1) {
     }
 
 public:
@@ -45,6 +45,7 @@ public:
     std::vector<Coordinate_2d> path;
     int net_id;
     int done;
+    int id;     //position in the 2-pin net list indexed by Congestion::index_two_pins(), -1 if not indexed
 
     int boxSize() const {
         return abs(pin1.x - pin2.x) + abs(pin1.y - pin2.y);
@@ -89,8 +90,7 @@ public:
 
 public:
 
-    double cost;               //Used as cache of cost in whole program
-    int MMVisitFlag;        //Used as cache of hash table lookup result in MM_mazeroute
+    double cost;               //Used as cache of the edge part of the cost in whole program, see Congestion::edge_cost()
 
     double cur_cap;
     double max_cap;
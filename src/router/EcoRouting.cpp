@@ -0,0 +1,241 @@
+/*
+ * EcoRouting.cpp
+ *
+ * Routing of a previous run reused by the nets whose pins did not change,
+ * so that a design change is routed incrementally.
+ */
+
+#include "EcoRouting.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../grdb/RoutingComponent.h"
+#include "../grdb/RoutingRegion.h"
+#include "../spdlog/details/spdlog_impl.h"
+#include "../spdlog/logger.h"
+#include "../spdlog/spdlog.h"
+#include "Congestion.h"
+
+namespace NTHUR {
+
+namespace {
+
+//Visit the unit steps of a segment whose first end is the lowest one
+void walk(const Segment3d& s, const std::function<void(const Coordinate_3d& a, const Coordinate_3d& b)>& f) {
+    for (Coordinate_3d a = s.first; !(a == s.last);) {
+        Coordinate_3d b = a;
+        if (b.x < s.last.x) {
+            ++b.x;
+        } else if (b.y < s.last.y) {
+            ++b.y;
+        } else {
+            ++b.z;
+        }
+        f(a, b);
+        a = b;
+    }
+}
+
+//Union-find of the vertices met by the routing of a net
+class Components {
+public:
+    long find(long v) {
+        auto it = parent.emplace(v, v).first;
+        if (it->second != v) {
+            it->second = find(it->second);
+        }
+        return it->second;
+    }
+    bool contains(long v) const {
+        return parent.find(v) != parent.end();
+    }
+    ///@return false if a and b were already connected
+    bool join(long a, long b) {
+        long ra = find(a);
+        long rb = find(b);
+        if (ra == rb) {
+            return false;
+        }
+        parent[ra] = rb;
+        return true;
+    }
+    std::size_t size() const {
+        return parent.size();
+    }
+
+private:
+    std::unordered_map<long, long> parent;
+};
+
+} // namespace
+
+EcoRouting::EcoRouting(const std::string& fileName, const RoutingRegion& rr) :
+        rr_map { rr }, //
+        nets(rr.get_netNumber()), //
+        keptNets { 0 } {
+
+    std::shared_ptr<spdlog::logger> log_sp = spdlog::get("NTHUR");
+    std::ifstream ifs(fileName);
+    if (!ifs) {
+        log_sp->error("previous routing {} not found", fileName);
+        exit(-1);
+    }
+    std::unordered_map<std::string, int> netIds;
+    netIds.reserve(rr.get_netNumber());
+    for (std::size_t i = 0; i < rr.get_netNumber(); ++i) {
+        netIds.emplace(rr.get_net(i).get_name(), i);
+    }
+
+    //The output is "name serial wires", the wires "(x,y,z)-(x,y,z)" at the GCell centers
+    //with the layers numbered from 1, and "!"
+    std::string line;
+    std::vector<Segment3d> segments;
+    while (std::getline(ifs, line)) {
+        std::istringstream header(line);
+        std::string name;
+        int serial;
+        int wires;
+        if (!(header >> name >> serial >> wires)) {
+            continue;
+        }
+        segments.clear();
+        bool valid = true;
+        for (int i = 0; i < wires && std::getline(ifs, line); ++i) {
+            int c[6];
+            if (std::sscanf(line.c_str(), " (%d,%d,%d)-(%d,%d,%d)", &c[0], &c[1], &c[2], &c[3], &c[4], &c[5]) != 6) {
+                valid = false;
+                continue;
+            }
+            Segment3d s;
+            s.first.set((c[0] - rr.get_llx()) / rr.get_tileWidth(), (c[1] - rr.get_lly()) / rr.get_tileHeight(), c[2] - 1);
+            s.last.set((c[3] - rr.get_llx()) / rr.get_tileWidth(), (c[4] - rr.get_lly()) / rr.get_tileHeight(), c[5] - 1);
+            if (c[0] < rr.get_llx() || c[1] < rr.get_lly() || c[3] < rr.get_llx() || c[4] < rr.get_lly() || !s.first.isAligned(s.last)) {
+                valid = false;
+                continue;
+            }
+            for (Coordinate_3d* e : { &s.first, &s.last }) {
+                if (e->x >= rr.get_gridx() || e->y >= rr.get_gridy() || e->z < 0 || e->z >= rr.get_layerNumber()) {
+                    valid = false;
+                }
+            }
+            if (s.last.x < s.first.x || s.last.y < s.first.y || s.last.z < s.first.z) {
+                std::swap(s.first, s.last);
+            }
+            segments.push_back(s);
+        }
+        std::unordered_map<std::string, int>::const_iterator id = netIds.find(name);
+        if (valid && id != netIds.end() && nets[id->second].empty() && check(id->second, segments)) {
+            nets[id->second] = segments;
+            ++keptNets;
+        }
+    }
+    log_sp->info("ECO: {} of {} nets keep the routing of {}", keptNets, rr.get_netNumber(), fileName);
+}
+
+//The wires projected on the GCells must form a tree whose leaves are pins and which covers
+//all the pins, and the wires and vias must connect the pins on the first layer.
+bool EcoRouting::check(int net_id, const std::vector<Segment3d>& segments) const {
+    const int ySize = rr_map.get_gridy();
+    const int zSize = rr_map.get_layerNumber();
+    auto index2d = [&](const Coordinate_3d& c) {
+        return static_cast<long>(c.x) * ySize + c.y;
+    };
+    auto index3d = [&](const Coordinate_3d& c) {
+        return index2d(c) * zSize + c.z;
+    };
+
+    Components tree;
+    Components wires;
+    std::unordered_map<long, int> degree;
+    std::size_t edges = 0;
+    bool valid = true;
+    for (const Segment3d& s : segments) {
+        walk(s, [&](const Coordinate_3d& a, const Coordinate_3d& b) {
+            wires.join(index3d(a), index3d(b));
+            if (a.z == b.z) {
+                ++edges;
+                ++degree[index2d(a)];
+                ++degree[index2d(b)];
+                valid = valid && tree.join(index2d(a), index2d(b));
+            }
+        });
+    }
+    if (!valid || edges == 0 || tree.size() != edges + 1) {
+        return false;
+    }
+
+    const std::vector<Net::Pin>& pins = rr_map.get_net(net_id).get_pinList();
+    std::unordered_set<long> pinTiles;
+    long root = -1;
+    for (const Net::Pin& pin : pins) {
+        Coordinate_3d c { pin.xy(), 0 };
+        pinTiles.insert(index2d(c));
+        if (!wires.contains(index3d(c))) {
+            return false;
+        }
+        long r = wires.find(index3d(c));
+        if (root >= 0 && r != root) {
+            return false;
+        }
+        root = r;
+    }
+    for (const std::pair<const long, int>& vertex : degree) {
+        if (vertex.second == 1 && pinTiles.find(vertex.first) == pinTiles.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Two_pin_element_2d> EcoRouting::paths_2d(int net_id) const {
+    std::vector<Two_pin_element_2d> paths;
+    for (const Segment3d& s : nets[net_id]) {
+        if (s.first.xy() == s.last.xy()) {
+            continue;
+        }
+        paths.emplace_back();
+        Two_pin_element_2d& path = paths.back();
+        path.net_id = net_id;
+        path.path.push_back(s.first.xy());
+        walk(s, [&](const Coordinate_3d&, const Coordinate_3d& b) {
+            path.path.push_back(b.xy());
+        });
+        path.pin1 = path.path.front();
+        path.pin2 = path.path.back();
+    }
+    return paths;
+}
+
+std::vector<char> EcoRouting::unchanged(const Congestion& congestion) const {
+    std::vector<int> edges(nets.size(), 0);
+    for (const Edge_2d& edge : congestion.congestionMap2d.all()) {
+        for (const std::pair<const int, int>& net : edge.used_net) {
+            ++edges[net.first];
+        }
+    }
+    std::vector<char> result(nets.size(), false);
+    for (std::size_t i = 0; i < nets.size(); ++i) {
+        int previous = 0;
+        bool same = kept(i);
+        for (const Segment3d& s : nets[i]) {
+            walk(s, [&](const Coordinate_3d& a, const Coordinate_3d& b) {
+                if (a.z == b.z) {
+                    ++previous;
+                    same = same && congestion.congestionMap2d.edge(a.xy(), b.xy()).lookupNet(i);
+                }
+            });
+        }
+        result[i] = same && previous == edges[i];
+    }
+    return result;
+}
+
+} // namespace NTHUR
@@ -0,0 +1,62 @@
+/*
+ * EcoRouting.h
+ *
+ * Routing of a previous run reused by the nets whose pins did not change,
+ * so that a design change is routed incrementally.
+ */
+
+#ifndef SRC_ROUTER_ECOROUTING_H_
+#define SRC_ROUTER_ECOROUTING_H_
+
+#include <string>
+#include <vector>
+
+#include "../misc/geometry.h"
+#include "DataDef.h"
+
+namespace NTHUR {
+
+class Congestion;
+class RoutingRegion;
+
+///@brief Previous routing of the nets for the ECO mode.
+///@details The output of a previous run is read and its nets are matched by name with the
+///         nets of the input. A net keeps its previous routing if the wires projected on the
+///         GCells form a tree whose leaves are pins of the net, covering all its pins, and if
+///         the wires and vias connect its pins. The other nets, new or changed, are routed again.
+///         The kept routing is inserted before the initial routing. The rip-up and reroute only
+///         takes the new or changed nets and the nets passing an overflowed edge, and stops at the
+///         first iteration that does not lower the overflow. The layer assignment keeps the layers
+///         of the kept nets whose 2D routing did not change.
+class EcoRouting {
+public:
+    ///@param fileName output of a previous run
+    ///@param rr new input
+    EcoRouting(const std::string& fileName, const RoutingRegion& rr);
+
+    bool kept(int net_id) const {
+        return !nets[net_id].empty();
+    }
+    int kept_nets() const {
+        return keptNets;
+    }
+    ///@brief Wires and vias of a kept net, in GCells, the layers numbered from 0
+    const std::vector<Segment3d>& segments(int net_id) const {
+        return nets[net_id];
+    }
+    ///@brief 2D paths of a kept net, one per wire
+    std::vector<Two_pin_element_2d> paths_2d(int net_id) const;
+    ///@brief Whether each net is a kept net with its previous 2D routing in the congestion map
+    std::vector<char> unchanged(const Congestion& congestion) const;
+
+private:
+    const RoutingRegion& rr_map;
+    std::vector<std::vector<Segment3d> > nets;  //previous routing of each net, empty if the net is routed again
+    int keptNets;
+
+    bool check(int net_id, const std::vector<Segment3d>& segments) const;
+};
+
+} // namespace NTHUR
+
+#endif /* SRC_ROUTER_ECOROUTING_H_ */
@@ -0,0 +1,57 @@
+/*
+ * IterationControl.cpp
+ *
+ * Convergence watch of the main stage: decides from the overflow reduction
+ * per second when the rip-up and reroute iterations stall.
+ */
+
+#include "IterationControl.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace NTHUR {
+
+IterationControl::IterationControl(double stallRate, int window, int maxEscalations) :
+        stallRate { stallRate }, //
+        window { std::max(1, window) }, //
+        maxEscalations { maxEscalations }, //
+        escalations { 0 } {
+}
+
+void IterationControl::start(int overflow) {
+    samples.clear();
+    samples.push_back(Sample { overflow, Clock::now() });
+}
+
+IterationControl::Action IterationControl::next(int overflow) {
+    if (!enabled()) {
+        return CONTINUE;
+    }
+    samples.push_back(Sample { overflow, Clock::now() });
+    if (static_cast<int>(samples.size()) <= window) {
+        return CONTINUE;
+    }
+    if (static_cast<int>(samples.size()) > window + 1) {
+        samples.pop_front();
+    }
+    const Sample& first = samples.front();
+    std::chrono::duration<double> elapsed = samples.back().time - first.time;
+    double rate = (first.overflow - overflow) / std::max(elapsed.count(), 1e-6);
+    if (rate >= stallRate) {
+        return CONTINUE;
+    }
+
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer), "overflow %d -> %d in %d iterations, %.1f per second < %g", first.overflow, overflow, window, rate, stallRate);
+    why = buffer;
+    if (escalations < maxEscalations) {
+        ++escalations;
+        //measure the escalated expansion on a new window
+        samples.erase(samples.begin(), samples.end() - 1);
+        return ESCALATE;
+    }
+    return HANDOVER;
+}
+
+} // namespace NTHUR
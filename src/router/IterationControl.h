@@ -0,0 +1,65 @@
+/*
+ * IterationControl.h
+ *
+ * Convergence watch of the main stage: decides from the overflow reduction
+ * per second when the rip-up and reroute iterations stall.
+ */
+
+#ifndef SRC_ROUTER_ITERATIONCONTROL_H_
+#define SRC_ROUTER_ITERATIONCONTROL_H_
+
+#include <chrono>
+#include <deque>
+#include <string>
+
+namespace NTHUR {
+
+///@brief Adaptive control of the main stage iterations.
+///@details The overflow reduction per second is measured over the last window
+///         iterations. Below stallRate, the bounding-box expansion is doubled, up to
+///         maxEscalations times, then the main stage hands over to the post processing.
+///         A stallRate of 0 disables the control.
+class IterationControl {
+public:
+    enum Action {
+        CONTINUE, ESCALATE, HANDOVER
+    };
+
+    IterationControl(double stallRate, int window, int maxEscalations);
+
+    bool enabled() const {
+        return stallRate > 0;
+    }
+    ///@brief Start the clock with the overflow before the first iteration
+    void start(int overflow);
+    ///@brief Record the overflow after an iteration and decide what to do next
+    Action next(int overflow);
+    ///@brief Bounding-box expansion of the next iteration for the user expansion base
+    int box_expand(int base) const {
+        return base << escalations;
+    }
+    ///@brief Why the last transition happened
+    const std::string& reason() const {
+        return why;
+    }
+
+private:
+    friend class Checkpoint;    //the rate window and the escalations are saved with the routing state
+    typedef std::chrono::steady_clock Clock;
+
+    struct Sample {
+        int overflow;
+        Clock::time_point time;
+    };
+
+    double stallRate;           //overflow reduction per second below which the stage stalls
+    int window;                 //iterations the rate is measured over
+    int maxEscalations;
+    int escalations;
+    std::deque<Sample> samples; //up to window + 1 samples, the first one is the reference
+    std::string why;
+};
+
+} // namespace NTHUR
+
+#endif /* SRC_ROUTER_ITERATIONCONTROL_H_ */
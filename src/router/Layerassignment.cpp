@@ -15,11 +15,13 @@
 #include "../grdb/EdgePlane.h"
 #include "../grdb/RoutingComponent.h"
 #include "../grdb/RoutingRegion.h"
+#include "../misc/ThreadPool.h"
 #include "../spdlog/details/logger_impl.h"
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
 #include "Congestion.h"
 #include "DataDef.h"
+#include "EcoRouting.h"
 
 namespace NTHUR {
 
@@ -66,7 +68,7 @@ void Layer_assignment::update_cur_map_for_klat_z(int min, int max, const Coordin
 
 }
 
-void Layer_assignment::update_path_for_klat(const Coordinate_2d& start) {
+void Layer_assignment::update_path_for_klat(const Coordinate_2d& start, int net_id, int net_pin_num) {
     int pin_num = 0;
     std::queue<ElementQueue<Coordinate_3d>> q;
 
@@ -93,20 +95,36 @@ void Layer_assignment::update_path_for_klat(const Coordinate_2d& start) {
                 int pi_z = layerInfo_map.vertex(c).klat[head3d.coor.z].pi_z;
                 z_max = std::max(z_max, pi_z);
                 z_min = std::min(z_min, pi_z);
-                update_cur_map_for_klat_xy(pi_z, h, c, global_net_id);
+                update_cur_map_for_klat_xy(pi_z, h, c, net_id);
                 q.emplace(Coordinate_3d { c, pi_z }, Coordinate_3d { h, pi_z });	// enqueue
             }
         }	//
-        update_cur_map_for_klat_z(z_min, z_max, h, global_net_id);
+        update_cur_map_for_klat_z(z_min, z_max, h, net_id);
         layerInfo_map.vertex(h).path = 0;	// visited
         q.pop();	// dequeue
     }
-    if (pin_num != global_pin_num) {
-        log_sp->error("net : {}, pin number error {} vs {}", global_net_id, pin_num, global_pin_num);
+    if (pin_num != net_pin_num) {
+        log_sp->error("net : {}, pin number error {} vs {}", net_id, pin_num, net_pin_num);
         exit(-1);
     }
 }
 
+//Insert the previous layers of a net, as update_path_for_klat() does with the assigned ones
+void Layer_assignment::keep_path(int net_id, const std::vector<Segment3d>& segments) {
+    for (const Segment3d& s : segments) {
+        if (s.first.xy() != s.last.xy()) {
+            Coordinate_2d c = s.first.xy();
+            while (c != s.last.xy()) {
+                Coordinate_2d next { c.x + (c.x < s.last.x), c.y + (c.x == s.last.x) };
+                update_cur_map_for_klat_xy(s.first.z, c, next, net_id);
+                c = next;
+            }
+        } else {
+            update_cur_map_for_klat_z(s.first.z, s.last.z, s.first.xy(), net_id);
+        }
+    }
+}
+
 void Layer_assignment::cycle_reduction(const Coordinate_2d& c, const Coordinate_2d& parent) {
 
     for (EdgePlane<EdgeInfo>::Handle& handle : layerInfo_map.edges().neighbors(c)) {
@@ -300,15 +318,13 @@ int Layer_assignment::klat(int net_id) { //SOLAC + APEC
     const std::vector<Net::Pin>& pin_list = output.get_nPin(net_id);
 
     Coordinate_2d start = pin_list[0].xy();
-    global_net_id = net_id; // LAZY global variable
-    global_pin_num = pin_list.size();
     preprocess(net_id);
 // Find a pin as starting point
 // klat start with a pin
 
     DP(start, start);
 
-    update_path_for_klat(start);
+    update_path_for_klat(start, net_id, pin_list.size());
     /*
      log_sp->info("update_path_for_klat  ");
      plotNet(net_id);
@@ -316,6 +332,93 @@ int Layer_assignment::klat(int net_id) { //SOLAC + APEC
     return layerInfo_map.vertex(start).klat[0].val;
 }
 
+/*
+ input: a net, and a map of the last net visited at each vertex
+ output: the vertices of the net, its pins and the vertices of its 2D routing
+ */
+void Layer_assignment::net_footprint(int net_id, std::vector<int>& visited, std::vector<Coordinate_2d>& vertices) {
+
+    vertices.clear();
+    for (const Net::Pin& pin : output.get_nPin(net_id)) {
+        int& v = visited[pin.x * max_yy + pin.y];
+        if (v != net_id) {
+            v = net_id;
+            vertices.push_back(pin.xy());
+        }
+    }
+// BFS, vertices is the queue
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        Coordinate_2d c = vertices[i];
+        for (EdgePlane<EdgeInfo>::Handle& handle : layerInfo_map.edges().neighbors(c)) {
+            int& v = visited[handle.vertex().x * max_yy + handle.vertex().y];
+            if (v != net_id && congestion.congestionMap2d.edge(c, handle.vertex()).lookupNet(net_id)) {
+                v = net_id;
+                vertices.push_back(handle.vertex());
+            }
+        }
+    }
+}
+
+/*
+ klat of the nets in order, by batches assigned concurrently. klat of a net only touches
+ its vertices and their edges, so a net joins the batch if none of its vertices is on or
+ next to a vertex of the nets of the batch, or of the nets it overtakes. The result is
+ the serial one.
+ */
+int Layer_assignment::klat_batches(const std::vector<int>& order) {
+
+    std::vector<std::vector<Coordinate_2d> > footprint(output.get_netNumber());
+    std::vector<std::vector<int> > visited(pool.size(), std::vector<int>(max_xx * max_yy, -1));
+    pool.parallel_for("net footprint", order.size(), [&](int i, int worker) {
+        net_footprint(order[i], visited[worker], footprint[order[i]]);
+    });
+
+    const std::size_t batchSize = 64 * pool.size();
+    const std::size_t window = 4 * batchSize;  // nets looked at for a batch
+    std::vector<int> mark(max_xx * max_yy, -1);  // last batch next to the vertex
+    std::vector<int> batch;
+    std::vector<int> cost;
+    std::vector<int> skipped;
+    std::vector<int> next;
+    std::size_t cursor = 0;
+    int total_cost = 0;
+    for (int round = 0; cursor < order.size() || !skipped.empty(); ++round) {
+        batch.clear();
+        next.clear();
+        std::size_t s = 0;
+        for (std::size_t scanned = 0; batch.size() < batchSize && scanned < window && (s < skipped.size() || cursor < order.size());
+                ++scanned) {
+            int net_id = (s < skipped.size()) ? skipped[s++] : order[cursor++];
+            const std::vector<Coordinate_2d>& vertices = footprint[net_id];
+            bool away = std::none_of(vertices.begin(), vertices.end(), [&](const Coordinate_2d& c) {
+                return mark[c.x * max_yy + c.y] == round;
+            });
+            if (away) {
+                batch.push_back(net_id);
+            } else {
+                next.push_back(net_id);
+            }
+            for (const Coordinate_2d& c : vertices) {
+                mark[c.x * max_yy + c.y] = round;
+                for (EdgePlane<EdgeInfo>::Handle& handle : layerInfo_map.edges().neighbors(c)) {
+                    mark[handle.vertex().x * max_yy + handle.vertex().y] = round;
+                }
+            }
+        }
+        next.insert(next.end(), skipped.begin() + s, skipped.end());
+        skipped.swap(next);
+
+        cost.resize(batch.size());
+        pool.parallel_for("layer assignment", batch.size(), [&](int i, int) {
+            cost[i] = klat(batch[i]);
+        });
+        for (int c : cost) {
+            total_cost += c;
+        }
+    }
+    return total_cost;
+}
+
 bool Layer_assignment::comp_temp_net_order(int p, int q) {
 
     return average_order[q].average < average_order[p].average || //
@@ -366,16 +469,30 @@ void Layer_assignment::sort_net_order() {
 
     find_group(max);
     initial_overflow_map();
-    std::vector<int> temp_net_order(max);
+    //the nets keeping their previous routing keep their layers, the other ones are assigned
+    std::vector<char> kept = eco ? eco->unchanged(congestion) : std::vector<char>(max, false);
+    std::vector<int> temp_net_order;
+    temp_net_order.reserve(max);
     for (int i = 0; i < max; ++i) {
-        temp_net_order[i] = i;
+        if (kept[i]) {
+            keep_path(i, eco->segments(i));
+        } else {
+            temp_net_order.push_back(i);
+        }
+    }
+    if (eco) {
+        log_sp->info("ECO: {} nets keep their layers", max - temp_net_order.size());
     }
     std::sort(temp_net_order.begin(), temp_net_order.end(), [&](int a,int b) {return comp_temp_net_order(a,b);});
     int global_pin_cost = 0;
     auto start = std::chrono::system_clock::now();
-    for (int i = 0; i < max; ++i) {
-        global_pin_cost += klat(temp_net_order[i]);	// others
+    if (pool.size() > 1) {
+        global_pin_cost = klat_batches(temp_net_order);
+    } else {
+        for (int net_id : temp_net_order) {
+            global_pin_cost += klat(net_id);	// others
 
+        }
     }
 
     auto end = std::chrono::system_clock::now();
@@ -387,9 +504,11 @@ void Layer_assignment::sort_net_order() {
 
 }
 
-Layer_assignment::Layer_assignment(const Congestion& congestion, OutputGeneration& output) :
+Layer_assignment::Layer_assignment(const Congestion& congestion, OutputGeneration& output, ThreadPool& pool, const EcoRouting* eco) :
         congestion { congestion }, //
         output { output }, //
+        pool { pool }, //
+        eco { eco }, //
         layerInfo_map { congestion.congestionMap2d.getSize() }  //
 
 {
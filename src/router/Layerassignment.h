@@ -19,8 +19,10 @@ class logger;
 namespace NTHUR {
 
 class RoutingRegion;
+class ThreadPool;
 
 class Congestion;
+class EcoRouting;
 
 struct KLAT_NODE {
     int val;
@@ -146,6 +148,8 @@ struct Layer_assignment {
     };
     const Congestion& congestion;
     OutputGeneration& output;
+    ThreadPool& pool;
+    const EcoRouting* eco;
     std::vector<AVERAGE_NODE> average_order;
     Plane<LayerInfo, EdgeInfo> layerInfo_map; //edge are overflow
 
@@ -153,8 +157,6 @@ struct Layer_assignment {
     int max_yy;
     int overflow_max;
 
-    int global_net_id;
-    int global_pin_num;
     int global_via_cost;
 
     std::shared_ptr<spdlog::logger> log_sp;
@@ -163,20 +165,24 @@ struct Layer_assignment {
     void initLayerInfo(const int max_z);
     void update_cur_map_for_klat_xy(int cur_idx, const Coordinate_2d& start, const Coordinate_2d& end, int net_id);
     void update_cur_map_for_klat_z(int min, int max, const Coordinate_2d& start, int net_id);
-    void update_path_for_klat(const Coordinate_2d& start);
+    void update_path_for_klat(const Coordinate_2d& start, int net_id, int net_pin_num);
+    void keep_path(int net_id, const std::vector<Segment3d>& segments);
     void cycle_reduction(const Coordinate_2d& c, const Coordinate_2d& parent);
     void preprocess(int net_id);
     std::vector<Coordinate_3d> rec_count(const Coordinate_3d& o, KLAT_NODE& klatNode);
     void DP(const Coordinate_3d& c, const Coordinate_3d& parent);
 
     int klat(int net_id);
+    void net_footprint(int net_id, std::vector<int>& visited, std::vector<Coordinate_2d>& vertices);
+    int klat_batches(const std::vector<int>& order);
     bool comp_temp_net_order(int p, int q);
 
     void find_group(int max);
 
     void sort_net_order();
 
-    Layer_assignment(const Congestion& congestion, OutputGeneration& output);
+    ///@param eco previous routing, whose layers are kept by the nets with an unchanged 2D routing
+    Layer_assignment(const Congestion& congestion, OutputGeneration& output, ThreadPool& pool, const EcoRouting* eco = nullptr);
 
 private:
     bool test(const Coordinate_2d& c1, const Coordinate_2d& c2);
@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <atomic>
 #include <iterator>
 #include <stack>
 
@@ -18,6 +19,7 @@
 #include "../spdlog/common.h"
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
+#include "CoarseGrid.h"
 #include "Congestion.h"
 #include "Construct_2d_tree.h"
 
@@ -28,23 +30,122 @@ namespace NTHUR {
 
 using namespace std;
 
-Multisource_multisink_mazeroute::Vertex_mmm::Vertex_mmm(const Coordinate_2d& xy) :
-        coor(xy), neighbor { }, visit(-1) {
+//NetTree::Vertex::visit lives in the shared net trees, so every maze router
+//takes its visit IDs from the same sequence to never reuse the ID of another one.
+static std::atomic<int> visit_sequence { 0 };
+
+void NetTree::clear() {
+    vertices.clear();
+    slots.clear();
+    freeSlot = -1;
+}
+
+void NetTree::build(const TreeFlute& t) {
+    clear();
+    vertices.reserve(t.number);
+    slots.reserve(2 * t.number);
+
+    std::unordered_map<Coordinate_2d, int> indexmap;
+    indexmap.reserve(t.number);
+
+    for (int i = 0; i < t.number; ++i) {
+
+        Coordinate_2d c { (int) t.branch[i].x, (int) t.branch[i].y };
+        bool inserted = indexmap.insert( { c, static_cast<int>(vertices.size()) }).second;
+        if (inserted) {
+            vertices.push_back( { c, -1, -1, -1 });
+        }
+    }
+
+    for (int i = 0; i < t.number; ++i) {
+        const Branch& b = t.branch[i];
+        Coordinate_2d c1 { (int) b.x, (int) b.y };
+        Coordinate_2d c2 { (int) t.branch[b.n].x, (int) t.branch[b.n].y };
+        if (c1 != c2) {
+            connect(indexmap.at(c1), indexmap.at(c2));
+        }
+    }
+}
+
+int NetTree::find(const Coordinate_2d& c) const {
+    for (int i = 0; i < (int) vertices.size(); ++i) {
+        if (vertices[i].coor == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void NetTree::connect(int v1, int v2) {
+    append(v1, v2);
+    append(v2, v1);
+}
+
+bool NetTree::disconnect(int v1, int v2) {
+    bool found = unlink(v1, v2);
+    return unlink(v2, v1) && found;
+}
+
+//append to the end of the adjacency so that neighbors keep their insertion order
+void NetTree::append(int from, int to) {
+    int s;
+    if (freeSlot != -1) {
+        s = freeSlot;
+        freeSlot = slots[s].next;
+        slots[s] = { to, -1 };
+    } else {
+        s = slots.size();
+        slots.push_back( { to, -1 });
+    }
+
+    Vertex& v = vertices[from];
+    if (v.last == -1) {
+        v.first = s;
+    } else {
+        slots[v.last].next = s;
+    }
+    v.last = s;
+}
+
+bool NetTree::unlink(int from, int to) {
+    Vertex& v = vertices[from];
+    int prev = -1;
+    for (int s = v.first; s != -1; prev = s, s = slots[s].next) {
+        if (slots[s].to == to) {
+            if (prev == -1) {
+                v.first = slots[s].next;
+            } else {
+                slots[prev].next = slots[s].next;
+            }
+            if (v.last == s) {
+                v.last = prev;
+            }
+            slots[s].next = freeSlot;
+            freeSlot = s;
+            return true;
+        }
+    }
+    return false;
 }
 
 Multisource_multisink_mazeroute::Multisource_multisink_mazeroute(Construct_2d_tree& construct_2d_tree, Congestion& congestion) :
         construct_2d_tree { construct_2d_tree }, //
         congestion { congestion }, //
         mmm_map { boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()] }, //
+        netEdge { congestion.congestionMap2d.getSize() }, //
         element { }, //
-        pin1_v { }, //
-        pin2_v { } {
+        tree { }, //
+        pin1_v { -1 }, //
+        pin2_v { -1 }, //
+        expanded { } {
     /*allocate space for mmm_map*/
     log_sp = spdlog::get("NTHUR");
-    net_tree.resize(construct_2d_tree.rr_map.get_netNumber());
 
     //initialization
 
+    for (int& e : netEdge.all()) {
+        e = -1;
+    }
     for (u_int32_t i = 0; i < mmm_map.size(); ++i) {
         for (u_int32_t j = 0; j < mmm_map[0].size(); ++j) {
             mmm_map[i][j].coor.set(i, j);
@@ -52,7 +153,7 @@ Multisource_multisink_mazeroute::Multisource_multisink_mazeroute(Construct_2d_tr
         }
     }
 
-    visit_counter = 0;
+    visit_counter = -1;
     dst_counter = 0;
 
 }
@@ -71,117 +172,79 @@ void Multisource_multisink_mazeroute::trace_back_to_find_path_2d(MMM_element *en
 }
 
 //store new 2pins and adjust dfs tree
-void Multisource_multisink_mazeroute::adjust_twopin_element() {
-
-    Coordinate_2d& new_pin1 = element->path.front();
-    Coordinate_2d& new_pin2 = element->path.back();
-    element->pin1 = new_pin1;
-    element->pin2 = new_pin2;
-
-    int flag = 0;
-    for (auto it = pin1_v->neighbor.begin(); it != pin1_v->neighbor.end(); ++it) {
-        if ((*it) == pin2_v) {
-            pin1_v->neighbor.erase(it);
-            flag = 1;
-            break;
-        }
-    }
-    assert(flag == 1);
+void Multisource_multisink_mazeroute::adjust_twopin_element(Two_pin_element_2d& element, NetTree& tree, int pin1_v, int pin2_v) {
 
-    flag = 0;
-    for (auto it = pin2_v->neighbor.begin(); it != pin2_v->neighbor.end(); ++it) {
-        if ((*it) == pin1_v) {
-            pin2_v->neighbor.erase(it);
-            flag = 1;
-            break;
-        }
-    }
-    assert(flag == 1);
+    Coordinate_2d& new_pin1 = element.path.front();
+    Coordinate_2d& new_pin2 = element.path.back();
+    element.pin1 = new_pin1;
+    element.pin2 = new_pin2;
 
-    int net_id = element->net_id;
-    Vertex_mmm* v1 = nullptr;
-    Vertex_mmm* v2 = nullptr;
-
-    vector<Vertex_mmm>& vect = net_tree[net_id];
-    for (vector<Vertex_mmm>::iterator it = vect.begin(); it != vect.end() && (v1 == nullptr || v2 == nullptr); ++it) {
-        if (it->coor == new_pin1) {
-            v1 = &(*it);
-        } else if (it->coor == new_pin2) {
-            v2 = &(*it);
-        }
-    }
-    assert(v1 != nullptr);
-    assert(v2 != nullptr);
+    bool found = tree.disconnect(pin1_v, pin2_v);
+    assert(found);
 
-    v1->neighbor.push_back(v2);
-    v2->neighbor.push_back(v1);
+    int v1 = tree.find(new_pin1);
+    int v2 = tree.find(new_pin2);
+    assert(v1 != -1);
+    assert(v2 != -1);
+
+    tree.connect(v1, v2);
 }
 
-void Multisource_multisink_mazeroute::find_subtree(Vertex_mmm& v, int mode) {
-    v.visit = visit_counter;
+//depth-first walk over the subtree reachable from v without crossing visited vertices
+void Multisource_multisink_mazeroute::find_subtree(int v, int mode) {
+    subtree_stack.clear();
+    subtree_stack.emplace_back(v, -2);
 
-    if (mode == 0) {
-        MMM_element& cur = mmm_map[v.coor.x][v.coor.y];
-        cur.reachCost = 0;
-        cur.distance = 0;
-        cur.via_num = 0;
-        cur.parent = &cur;
-        cur.visit = visit_counter;
-        cur.handle = pqueue.push(&cur);
+    while (!subtree_stack.empty()) {
+        int cur_v = subtree_stack.back().first;
+        int& slot = subtree_stack.back().second;
 
-        SPDLOG_TRACE(log_sp, "find_subtree cur {}", cur.toString());
+        if (slot == -2) {
+            NetTree::Vertex& vert = tree->vertices[cur_v];
+            vert.visit = visit_counter;
 
-    } else {
-        mmm_map[v.coor.x][v.coor.y].dst = dst_counter;
-    }
-    for (Vertex_mmm * neighbor : v.neighbor) {
-        if (neighbor->visit != visit_counter)
-            find_subtree(*neighbor, mode);
-    }
-}
+            if (mode == 0) {
+                MMM_element& cur = mmm_map[vert.coor.x][vert.coor.y];
+                cur.reachCost = 0;
+                cur.distance = 0;
+                cur.via_num = 0;
+                cur.parent = &cur;
+                cur.visit = visit_counter;
+                cur.handle = pqueue.push(&cur);
+
+                SPDLOG_TRACE(log_sp, "find_subtree cur {}", cur.toString());
 
-void Multisource_multisink_mazeroute::clear_net_tree() {
+            } else {
+                mmm_map[vert.coor.x][vert.coor.y].dst = dst_counter;
+            }
+            slot = vert.first;
+        } else {
+            slot = tree->slots[slot].next;
+        }
 
-    net_tree.clear();
-    net_tree.resize(construct_2d_tree.rr_map.get_netNumber());
+        if (slot == -1) {
+            subtree_stack.pop_back();
+            continue;
+        }
 
+        int neighbor = tree->slots[slot].to;
+        if (tree->vertices[neighbor].visit != visit_counter) {
+            subtree_stack.emplace_back(neighbor, -2);
+        }
+    }
 }
 
 void Multisource_multisink_mazeroute::setup_pqueue() {
 
     int cur_net = element->net_id;
-    vector<Vertex_mmm>& vertexV = net_tree[cur_net];
-    if (vertexV.empty()) {
+    tree = &construct_2d_tree.net_tree[cur_net];
+    if (tree->empty()) {
         const TreeFlute& t = construct_2d_tree.net_flutetree[cur_net];
 
         if (log_sp->level() == spdlog::level::trace) {
             log_sp->trace(t.plot());
         }
-        vertexV.reserve(t.number); // avoid re allocation that could invalidate pointer
-
-        std::unordered_map<Coordinate_2d, int> indexmap;
-        indexmap.reserve(t.number);
-
-        for (int i = 0; i < t.number; ++i) {
-
-            Coordinate_2d c { (int) t.branch[i].x, (int) t.branch[i].y };
-            bool inserted = indexmap.insert( { c, static_cast<int>(vertexV.size()) }).second;
-            if (inserted) {
-                vertexV.emplace_back(c);
-            }
-        }
-
-        for (int i = 0; i < t.number; ++i) {
-            Branch b = t.branch[i];
-            Coordinate_2d c1 { (int) b.x, (int) b.y };
-            Coordinate_2d c2 { (int) t.branch[b.n].x, (int) t.branch[b.n].y };
-            Vertex_mmm& v1 = vertexV.at(indexmap.at(c1));
-            Vertex_mmm& v2 = vertexV.at(indexmap.at(c2));
-            if (v1.coor != v2.coor) {
-                v1.neighbor.push_back(&v2);
-                v2.neighbor.push_back(&v1);
-            }
-        }
+        tree->build(t);
     }
 
     while (!pqueue.empty()) {
@@ -191,28 +254,29 @@ void Multisource_multisink_mazeroute::setup_pqueue() {
     }
 
 //find pin1 and pin2 in tree
-    pin1_v = nullptr;
-    pin2_v = nullptr;
-    for (Vertex_mmm& vert : vertexV) {
+    pin1_v = -1;
+    pin2_v = -1;
+    for (int i = 0; i < (int) tree->vertices.size(); ++i) {
+        NetTree::Vertex& vert = tree->vertices[i];
         if (vert.coor == element->pin1) {
-            pin1_v = &vert;
-            pin1_v->visit = visit_counter;
+            pin1_v = i;
+            vert.visit = visit_counter;
         } else if (vert.coor == element->pin2) {
-            pin2_v = &vert;
-            pin2_v->visit = visit_counter;
+            pin2_v = i;
+            vert.visit = visit_counter;
         }
 
-        if (pin1_v != nullptr && pin2_v != nullptr) {
+        if (pin1_v != -1 && pin2_v != -1) {
             break;
         }
 
     }
 
-    assert(pin1_v != nullptr);
-    assert(pin2_v != nullptr);
+    assert(pin1_v != -1);
+    assert(pin2_v != -1);
 
-    find_subtree(*pin1_v, 0);	//source
-    find_subtree(*pin2_v, 1);	//destination
+    find_subtree(pin1_v, 0);	//source
+    find_subtree(pin2_v, 1);	//destination
 }
 
 void Multisource_multisink_mazeroute::bfsSetColorMap(const Coordinate_2d& c1) {
@@ -227,18 +291,24 @@ void Multisource_multisink_mazeroute::bfsSetColorMap(const Coordinate_2d& c1) {
         mmm_map[c.x][c.y].walkableID = visit_counter;
 
         for (EdgePlane<Edge_2d>::Handle& h : congestion.congestionMap2d.neighbors(c)) {
-            if (h.edge().MMVisitFlag != visit_counter && h.edge().lookupNet(net_id)) {
-                h.edge().MMVisitFlag = visit_counter;
+            int& visit = netEdge.edge(c, h.vertex());
+            if (visit != visit_counter && h.edge().lookupNet(net_id)) {
+                visit = visit_counter;
                 Q.push(h.vertex());
             }
 
         }
     }
 }
-bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ielement, double bound_cost, int bound_distance, int bound_via_num, Coordinate_2d& start, Coordinate_2d& end, int version) {
+//When a corridor is given, only the GCells of the window lying in the corridor are walkable.
+//Without adjust, the found path is only stored in ielement.path and the caller has to
+//call adjust_twopin_element before the net is routed again.
+bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ielement, double bound_cost, int bound_distance, int bound_via_num, Coordinate_2d& start, Coordinate_2d& end, int version,
+        const Corridor* corridor, bool adjust) {
 
     bool find_path_flag = false;
 
+    visit_counter = visit_sequence++;
     MMM_element* sink_pos = nullptr;
     element = &ielement;
     element->path.clear();
@@ -253,7 +323,9 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
 
     for (int x = boundary_l; x <= boundary_r; ++x) {
         for (int y = boundary_b; y <= boundary_t; ++y) {
-            mmm_map[x][y].walkableID = visit_counter;
+            if (corridor == nullptr || corridor->contains(Coordinate_2d { x, y })) {
+                mmm_map[x][y].walkableID = visit_counter;
+            }
         }
     }
 
@@ -264,6 +336,9 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
 
         pqueue.pop();
         cur_pos.resetHandle();
+        if (expanded != nullptr) {
+            expanded->push_back(cur_pos.coor);
+        }
         for (EdgePlane<Edge_2d>::Handle& h : congestion.congestionMap2d.neighbors(cur_pos.coor)) {
 
             MMM_element& next_pos = mmm_map[h.vertex().x][h.vertex().y];
@@ -281,10 +356,11 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
                 int via_num = cur_pos.via_num;
                 bool addDistance = false;
 
+                bool netEdgeFlag = netEdge.edge(cur_pos.coor, h.vertex()) == visit_counter;
                 if (version == 2) {
 
-                    if (h.edge().MMVisitFlag != visit_counter) {
-                        reachCost += h.edge().cost;
+                    if (!netEdgeFlag) {
+                        reachCost += congestion.edge_cost(h.edge());
                         ++total_distance;
                         addDistance = true;
                     }
@@ -298,8 +374,9 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
                     }
 
                 } else { // version==3
-                    if ((h.edge().MMVisitFlag != visit_counter) && (h.edge().cost != 0.0)) {
-                        reachCost += h.edge().cost;
+                    const double cost = congestion.edge_cost(h.edge());
+                    if (!netEdgeFlag && (cost != 0.0)) {
+                        reachCost += cost;
                         ++total_distance;
                     }
 
@@ -349,12 +426,13 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
         if (sink_pos != nullptr) {
             find_path_flag = true;
             trace_back_to_find_path_2d(sink_pos);
-            adjust_twopin_element();
+            if (adjust) {
+                adjust_twopin_element(*element, *tree, pin1_v, pin2_v);
+            }
             break;
         }
     }
 
-    ++visit_counter;
     ++dst_counter;
 
     SPDLOG_TRACE(log_sp, "ielement {}", ielement.toString());
@@ -364,8 +442,8 @@ bool Multisource_multisink_mazeroute::mm_maze_route_p(Two_pin_element_2d &ieleme
 
 inline
 void Multisource_multisink_mazeroute::putNetOnColorMap() {
-    bfsSetColorMap(pin1_v->coor);
-    bfsSetColorMap(pin2_v->coor);
+    bfsSetColorMap(tree->vertices[pin1_v].coor);
+    bfsSetColorMap(tree->vertices[pin2_v].coor);
 }
 
 bool Multisource_multisink_mazeroute::smaller_than_lower_bound(double total_cost, int distance, int via_num, double bound_cost, int bound_distance, int bound_via_num) {
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "../grdb/EdgePlane.h"
 #include "../misc/geometry.h"
 #include "DataDef.h"
 namespace spdlog {
@@ -19,6 +20,7 @@ namespace NTHUR {
 
 
 class Congestion;
+class Corridor;
 
 struct Construct_2d_tree;
 
@@ -26,28 +28,67 @@ using namespace std;
 
 class Two_pin_element_2d;
 
-class Multisource_multisink_mazeroute {
-private:
-    class Vertex_mmm {
-    public:
-        Coordinate_2d coor;
+struct TreeFlute;
 
-        std::vector<Vertex_mmm*> neighbor;
+/**
+ * Connection graph of one net as seen by the multi-source multi-sink maze router.
+ * Vertices are the pins and Steiner points of the net; each edge is a 2-pin connection.
+ * Adjacency is stored as index-linked slots so that the graph can be kept across
+ * iterations and updated in place when a connection is rerouted.
+ */
+class NetTree {
+public:
+    struct Vertex {
+        Coordinate_2d coor;
         int visit;
+        int first;  // first adjacency slot, -1 if none
+        int last;   // last adjacency slot, -1 if none
+    };
 
-        Vertex_mmm(const Coordinate_2d& xy);
+    struct Slot {
+        int to;     // neighbor vertex index
+        int next;   // next slot of the same vertex (or of the free list)
+    };
 
-        std::string toString() const {
-            std::string s = "coor:" + coor.toString();
-            s += " neighbor:[";
-            for (Vertex_mmm* v : neighbor) {
-                s += v->coor.toString() + " ";
-            }
-            s += "] visit:" + std::to_string(visit);
-            return s;
+    std::vector<Vertex> vertices;
+    std::vector<Slot> slots;
+    int freeSlot;
+
+    NetTree() :
+            freeSlot(-1) {
+    }
+
+    bool empty() const {
+        return vertices.empty();
+    }
+
+    void clear();
+    void build(const TreeFlute& t);
+
+    // index of the vertex at c, -1 if c is not a vertex of the tree
+    int find(const Coordinate_2d& c) const;
+
+    void connect(int v1, int v2);
+    // remove one v1-v2 connection, return false if none
+    bool disconnect(int v1, int v2);
+
+    std::string toString(int v) const {
+        std::string s = "coor:" + vertices[v].coor.toString();
+        s += " neighbor:[";
+        for (int i = vertices[v].first; i != -1; i = slots[i].next) {
+            s += vertices[slots[i].to].coor.toString() + " ";
         }
-    };
+        s += "] visit:" + std::to_string(vertices[v].visit);
+        return s;
+    }
 
+private:
+    void append(int from, int to);
+    bool unlink(int from, int to);
+};
+
+class Multisource_multisink_mazeroute {
+private:
     class MMM_element {
 
         class MMM_element_greater {
@@ -123,13 +164,20 @@ public:
     Multisource_multisink_mazeroute(const Multisource_multisink_mazeroute&) = delete;
     void operator=(const Multisource_multisink_mazeroute&) = delete;
 
-    bool mm_maze_route_p(Two_pin_element_2d&element, double bound_cost, int bound_distance, int bound_via_num, Coordinate_2d& start, Coordinate_2d& end, int version);
-    void clear_net_tree();
+    bool mm_maze_route_p(Two_pin_element_2d&element, double bound_cost, int bound_distance, int bound_via_num, Coordinate_2d& start, Coordinate_2d& end, int version,
+            const Corridor* corridor = nullptr, bool adjust = true);
+
+    ///@brief Append the GCells expanded by the next searches to cells, or stop if null.
+    void record_expanded(std::vector<Coordinate_2d>* cells) {
+        expanded = cells;
+    }
+
+    ///@brief Move the tree connection pin1_v-pin2_v of element to the ends of its new path.
+    static void adjust_twopin_element(Two_pin_element_2d& element, NetTree& tree, int pin1_v, int pin2_v);
 
 private:
     void setup_pqueue();
-    void find_subtree(Vertex_mmm& v, int mode);
-    void adjust_twopin_element();
+    void find_subtree(int v, int mode);
     void trace_back_to_find_path_2d(MMM_element *end_point);
 
     //Cache System
@@ -142,14 +190,17 @@ private:
     Construct_2d_tree& construct_2d_tree;
     Congestion& congestion;
     boost::multi_array<MMM_element, 2> mmm_map;
+    EdgePlane<int> netEdge;     //edges of the routed net, set to visit_counter
 
-    vector<vector<Vertex_mmm> > net_tree;
     MMM_element::MMMPriortyQueue pqueue;
     Two_pin_element_2d *element;
-    Vertex_mmm* pin1_v;
-    Vertex_mmm* pin2_v;	//source,destination
+    NetTree* tree;      //tree of the net being routed
+    int pin1_v;
+    int pin2_v;	//source,destination
+    std::vector<std::pair<int, int> > subtree_stack;   //(vertex, next slot) of find_subtree
     int visit_counter;
     int dst_counter;
+    std::vector<Coordinate_2d>* expanded;
     std::shared_ptr<spdlog::logger> log_sp;
 };
 
@@ -9,8 +9,10 @@
 #include "../spdlog/details/logger_impl.h"
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
+#include "../misc/ThreadPool.h"
 #include "Congestion.h"
 #include "Construct_2d_tree.h"
+#include "EcoRouting.h"
 #include "Layerassignment.h"
 #include "parameter.h"
 
@@ -50,10 +52,16 @@ int main(int argc, char* argv[]) {
 
     log.info(" Total nets to route= {}", routingData.get_netNumber());
 
-    NTHUR::Congestion congestion(routingData.get_gridx(), routingData.get_gridy());
+    NTHUR::ThreadPool pool(ap.routing_param().get_threads());
+    NTHUR::Congestion congestion(routingData.get_gridx(), routingData.get_gridy(), pool);
+
+    std::unique_ptr<NTHUR::EcoRouting> eco;
+    if (!ap.routing_param().get_eco_file().empty()) {
+        eco.reset(new NTHUR::EcoRouting(ap.routing_param().get_eco_file(), routingData));
+    }
 
     auto t1 = std::chrono::system_clock::now();
-    NTHUR::Construct_2d_tree tree(ap.routing_param(), routingData, congestion);
+    NTHUR::Construct_2d_tree tree(ap.routing_param(), routingData, congestion, pool, eco.get());
     auto t2 = std::chrono::system_clock::now();
     // now the post processing is handle by Construct_2d_tree
 
@@ -66,14 +74,14 @@ int main(int argc, char* argv[]) {
     } else {
         //ISPD'07 Cases
         NTHUR::OutputGeneration output(routingData);
-        NTHUR::Layer_assignment layerAssignement(congestion, output);
+        NTHUR::Layer_assignment layerAssignement(congestion, output, pool, eco.get());
 
         log.info("Layer assignment complete.");
         log.info("Outputting result file to {}", ap.output());
 
         std::ofstream ofs(ap.output(), std::ofstream::out | std::ofstream::trunc);
 
-        output.generate_all_output(ofs);
+        output.generate_all_output(ofs, pool);
         ofs << std::flush;
         auto t4 = std::chrono::system_clock::now();
         std::chrono::duration<double> duration42 = t4 - t2;
@@ -81,6 +89,10 @@ int main(int argc, char* argv[]) {
         log.info(" time: {} {}", duration42.count(), duration40.count());
     }
 
+    if (pool.size() > 1) {
+        log.info("thread pool of {} workers:\n{}", pool.size(), pool.timingToString());
+    }
+
     return 0;
 }
 
@@ -20,12 +20,12 @@
 
 namespace NTHUR {
 
-
-MonotonicRouting::MonotonicRouting(Congestion& congestion, bool enable) :
+MonotonicRouting::MonotonicRouting(Congestion& congestion, bool enable, int wavefrontMaxCells) :
         congestion { congestion }, //
         cong_monotonic { boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()] }, //
         parent_monotonic { boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()] }, //
-        monotonic_enable { enable }
+        monotonic_enable { enable }, //
+        wavefront_max_cells { wavefrontMaxCells }
 //
 {
 
@@ -117,6 +117,201 @@ void MonotonicRouting::monotonic_routing_algorithm(int x1, int y1, int x2, int y
     }
 }
 
+//Same dynamic programming as monotonic_routing_algorithm, swept by anti-diagonal
+//over dense copies of the edge costs of the bounding box. The floating point
+//operations and the tie-breaks are the same, so are the paths.
+void MonotonicRouting::monotonic_wavefront_algorithm(int x1, int y1, int x2, int y2, OrientationType dir, int net_id, Bound& bound) {
+
+    const int width = x2 - x1;
+    const int height = std::abs(y2 - y1);
+    const int step = (dir == BACK) ? 1 : -1;
+    const int diagonals = width + height + 1;
+
+    //cell (u, v) is (x1 + u, y1 + step * v), stored at offset[u + v] + u - first(u + v)
+    auto first = [height](int d) {return std::max(0, d - height);};
+    wave.offset.resize(diagonals + 1);
+    wave.offset[0] = 0;
+    for (int d = 0; d < diagonals; ++d) {
+        wave.offset[d + 1] = wave.offset[d] + std::min(width, d) - first(d) + 1;
+    }
+    const int cells = wave.offset[diagonals];
+    for (std::vector<double>* field : { &wave.leftCost, &wave.leftDistance, &wave.verticalCost, &wave.verticalDistance, //
+            &wave.maxCost, &wave.totalCost, &wave.distance, &wave.viaNum, &wave.parent }) {
+        field->resize(cells);
+    }
+
+    double* maxCost = wave.maxCost.data();
+    double* totalCost = wave.totalCost.data();
+    double* dist = wave.distance.data();
+    double* viaNum = wave.viaNum.data();
+    double* parent = wave.parent.data();
+    double* leftCost = wave.leftCost.data();
+    double* leftDistance = wave.leftDistance.data();
+    double* verticalCost = wave.verticalCost.data();
+    double* verticalDistance = wave.verticalDistance.data();
+
+    const bool boundFlag = bound.flag;
+    const double boundCost = bound.cost;
+    const double boundDistance = bound.distance;
+    const double boundVia = bound.via_num;
+    const double via = congestion.via_cost;
+    const bool history = congestion.used_cost_flag == HISTORY_COST;
+    const double vertical = dir;
+
+    //cells of the top or bottom boundary and of the left boundary have a single neighbour
+    auto boundary = [=](int k, int pre, double cost, double distance, double code, bool prune) {
+        if (parent[pre] != -2) {
+            maxCost[k] = std::max(cost, maxCost[pre]);
+            totalCost[k] = totalCost[pre] + std::max(0., cost);
+            dist[k] = dist[pre] + distance;
+            viaNum[k] = viaNum[pre];
+            double d = totalCost[k] - boundCost;
+            bool smaller = (d < neg_error_bound) || (!(d > error_bound) && //
+                    (dist[k] < boundDistance || (dist[k] == boundDistance && viaNum[k] < boundVia)));
+            parent[k] = (!prune || !boundFlag || smaller) ? code : -2;
+        } else
+            parent[k] = -2;
+    };
+
+//initialize the source
+    maxCost[0] = -1000000;
+    totalCost[0] = 0;
+    dist[0] = 0;
+    viaNum[0] = 0;
+    parent[0] = -1;
+
+//[liveBegin, liveEnd] holds the reachable cells of the previous diagonal. A cell
+//whose two neighbours are out of it is unreachable, so is not evaluated.
+    int liveBegin = 0;
+    int liveEnd = 0;
+    for (int d = 1; d < diagonals; ++d) {
+        const int lo = first(d);
+        const int hi = std::min(width, d);
+        const int curBase = wave.offset[d] - lo;
+        const int preBase = wave.offset[d - 1] - first(d - 1);
+        const int begin = std::max(lo, liveBegin);
+        const int end = std::min(hi, liveEnd + 1);
+        if (begin > end) {
+            std::fill(parent + curBase + lo, parent + curBase + hi + 1, -2.);
+            liveBegin = width + 1;
+            liveEnd = width;
+            continue;
+        }
+        std::fill(parent + curBase + lo, parent + curBase + begin, -2.);
+        std::fill(parent + curBase + end + 1, parent + curBase + hi + 1, -2.);
+
+        //gather the costs of the edges from the reachable neighbours
+        int distance;
+        for (int u = begin; u <= end; ++u) {
+            const int k = curBase + u;
+            const Coordinate_2d c(x1 + u, y1 + step * (d - u));
+            if (u > 0 && parent[preBase + u - 1] != -2) {
+                leftCost[k] = congestion.get_cost_2d(Coordinate_2d(c.x - 1, c.y), c, net_id, distance);
+                leftDistance[k] = distance;
+            }
+            if (u < d && parent[preBase + u] != -2) {
+                verticalCost[k] = congestion.get_cost_2d(Coordinate_2d(c.x, c.y - step), c, net_id, distance);
+                verticalDistance[k] = distance;
+            }
+        }
+
+        //the scalar version never prunes the left boundary when the source is in the left-bottom corner
+        if (begin == 0) {
+            boundary(curBase, preBase, verticalCost[curBase], verticalDistance[curBase], vertical, dir != BACK);
+        }
+        if (end == d) {
+            boundary(curBase + d, preBase + d - 1, leftCost[curBase + d], leftDistance[curBase + d], LEFT, true);
+        }
+
+        //inner cells. The conditions are combined with bitwise operators, so the loop
+        //body has no branch and is vectorized: cell (u, v) and its neighbours (u - 1, v)
+        //and (u, v - 1) are at k, k - shift - 1 and k - shift. The cells written belong
+        //to this diagonal and the cells read to the previous one, hence ivdep.
+        const int shift = curBase - preBase;
+        const int innerEnd = std::min(end, d - 1);
+#pragma GCC ivdep
+        for (int u = std::max(begin, 1); u <= innerEnd; ++u) {
+            const int k = curBase + u;
+            const int l = k - shift - 1;
+            const int b = k - shift;
+            const double i = x1 + u;
+            const bool notBottom = (y1 + step * (d - u)) != 0;
+
+            const double lCost = leftCost[k];
+            const double lDist = leftDistance[k];
+            const bool lBend = (parent[l] != i) & notBottom;
+            const bool lVia = lBend & (lDist != 0);
+            const double lMax = std::max(lCost, maxCost[l]);
+            const double lTotal = totalCost[l] + std::max(0., lCost) + ((lVia & history) ? via : 0.);
+            const double lDistance = dist[l] + lDist + (lVia ? via : 0.);
+            const double lViaNum = viaNum[l] + (lBend ? via : 0.);
+            const double lBoundDiff = lTotal - boundCost;
+            const bool lFlag = (parent[l] != -2) & (!boundFlag | (lBoundDiff < neg_error_bound) | //
+                    ((!(lBoundDiff > error_bound)) & ((lDistance < boundDistance) | ((lDistance == boundDistance) & (lViaNum < boundVia)))));
+
+            const double vCost = verticalCost[k];
+            const double vDist = verticalDistance[k];
+            const bool vBend = (parent[b] != i) & notBottom;
+            const bool vVia = vBend & (vDist != 0);
+            const double vMax = std::max(vCost, maxCost[b]);
+            const double vTotal = totalCost[b] + std::max(0., vCost) + ((vVia & history) ? via : 0.);
+            const double vDistance = dist[b] + vDist + (vVia ? via : 0.);
+            const double vViaNum = viaNum[b] + (vBend ? via : 0.);
+            const double vBoundDiff = vTotal - boundCost;
+            const bool vFlag = (parent[b] != -2) & (!boundFlag | (vBoundDiff < neg_error_bound) | //
+                    ((!(vBoundDiff > error_bound)) & ((vDistance < boundDistance) | ((vDistance == boundDistance) & (vViaNum < boundVia)))));
+
+            //Monotonic_element::operator <
+            const double totalDiff = lTotal - vTotal;
+            const double maxDiff = lMax - vMax;
+            const bool lSmaller = (totalDiff < neg_error_bound) | ((!(totalDiff > neg_error_bound)) & //
+                    ((maxDiff < neg_error_bound) | ((!(maxDiff > neg_error_bound)) & //
+                            ((lDistance < vDistance) | ((lDistance == vDistance) & (lViaNum <= vViaNum))))));
+            const bool chooseLeft = lFlag & (!vFlag | lSmaller);
+
+            maxCost[k] = chooseLeft ? lMax : vMax;
+            totalCost[k] = chooseLeft ? lTotal : vTotal;
+            dist[k] = chooseLeft ? lDistance : vDistance;
+            viaNum[k] = chooseLeft ? lViaNum : vViaNum;
+            parent[k] = (lFlag | vFlag) ? (chooseLeft ? static_cast<double>(LEFT) : vertical) : -2;
+        }
+
+        liveBegin = begin;
+        while (liveBegin <= end && parent[curBase + liveBegin] == -2) {
+            ++liveBegin;
+        }
+        liveEnd = end;
+        while (liveEnd >= liveBegin && parent[curBase + liveEnd] == -2) {
+            --liveEnd;
+        }
+    }
+
+//copy back what traverse_parent_monotonic and monotonicRoute read:
+//the parents along the path from the sink, and the cost of the sink
+    int u = width;
+    int v = height;
+    const int sink = wave.offset[diagonals - 1] + width - first(diagonals - 1);
+    if (parent[sink] != -2) {
+        Monotonic_element& ele = cong_monotonic[x2][y2];
+        ele.max_cost = maxCost[sink];
+        ele.total_cost = totalCost[sink];
+        ele.distance = dist[sink];
+        ele.via_num = viaNum[sink];
+    }
+    while (true) {
+        const int k = wave.offset[u + v] + u - first(u + v);
+        parent_monotonic[x1 + u][y1 + step * v] = static_cast<int>(parent[k]);
+        if (parent[k] == -2 || parent[k] == -1) {
+            break;
+        }
+        if (parent[k] == LEFT) {
+            --u;
+        } else {
+            --v;
+        }
+    }
+}
+
 void MonotonicRouting::traverse_parent_monotonic(int x1, int y1, int x2, int y2, Two_pin_element_2d& two_pin_monotonic_path) {
     int i = x2;
     int j = y2;
@@ -145,11 +340,13 @@ bool MonotonicRouting::monotonic_pattern_route(int x1, int y1, int x2, int y2, T
         std::swap(x1, x2);
         std::swap(y1, y2);
     }
-    if (y1 <= y2) //s->t RIGHT and FRONT (source is in the left-bottom corner)
-        monotonic_routing_algorithm(x1, y1, x2, y2, BACK, net_id, bound);
-// use x1,y+1.edge_list[back]
-    else if (y1 > y2) //s->t RIGHT and BACK (source is in the left-top corner)
-        monotonic_routing_algorithm(x1, y1, x2, y2, FRONT, net_id, bound);
+    OrientationType dir = (y1 <= y2) ? BACK : FRONT;
+//s->t RIGHT and FRONT (source is in the left-bottom corner) or RIGHT and BACK (source is in the left-top corner).
+//On larger boxes, gathering the edge costs dominates and the wavefront no longer pays.
+    if ((x2 - x1 + 1) * (std::abs(y2 - y1) + 1) <= wavefront_max_cells)
+        monotonic_wavefront_algorithm(x1, y1, x2, y2, dir, net_id, bound);
+    else
+        monotonic_routing_algorithm(x1, y1, x2, y2, dir, net_id, bound);
 
 //If there is no solution for this 2-pin net, return false
     if (parent_monotonic[x2][y2] == -2)
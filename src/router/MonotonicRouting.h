@@ -9,11 +9,14 @@
 #define SRC_ROUTER_MONOTONICROUTING_H_
 
 #include <boost/multi_array.hpp>
+#include <vector>
 
 #include "../misc/geometry.h"
 
 namespace NTHUR {
 
+///@brief Default largest bounding box, in cells, routed by monotonic_wavefront_algorithm (--wavefront-max-cells)
+constexpr int WAVEFRONT_MAX_CELLS = 150 * 150;
 
 class Congestion;
 class Two_pin_element_2d;
@@ -39,7 +42,7 @@ public:
 class MonotonicRouting {
 public:
 
-    MonotonicRouting(Congestion& congestion, bool enable);
+    MonotonicRouting(Congestion& congestion, bool enable, int wavefrontMaxCells = WAVEFRONT_MAX_CELLS);
     virtual ~MonotonicRouting();
     bool monotonic_pattern_route(int x1, int y1, int x2, int y2, Two_pin_element_2d& two_pin_monotonic_path, int net_id, Bound& bound);
 
@@ -54,8 +57,30 @@ private:
     boost::multi_array<Monotonic_element, 2> cong_monotonic; //store max congestion during monotonic path
     boost::multi_array<Coordinate_2d, 2> parent_monotonic;             //record parent (x,y) during finding monotonic path
 
+    /**
+     @brief Cells of the bounding box stored by anti-diagonal, one dense array per field.
+     @details The cells of an anti-diagonal only depend on the previous one, and
+              both of their neighbours are contiguous in it, so the sweep of a
+              diagonal is a straight loop the compiler can vectorize. All fields
+              are doubles to keep every lane the same width.
+     **/
+    struct Wavefront {
+        std::vector<int> offset;                    ///< first cell of every anti-diagonal
+        std::vector<double> leftCost;               ///< cost of the edge to the left neighbour
+        std::vector<double> leftDistance;
+        std::vector<double> verticalCost;           ///< cost of the edge to the vertical neighbour
+        std::vector<double> verticalDistance;
+        std::vector<double> maxCost;
+        std::vector<double> totalCost;
+        std::vector<double> distance;
+        std::vector<double> viaNum;
+        std::vector<double> parent;                 ///< same codes as parent_monotonic
+    } wave;
+
     bool monotonic_enable;
+    int wavefront_max_cells;    //larger bounding boxes are routed by monotonic_routing_algorithm
     void monotonic_routing_algorithm(int x1, int y1, int x2, int y2, OrientationType dir, int net_id, Bound& bound);
+    void monotonic_wavefront_algorithm(int x1, int y1, int x2, int y2, OrientationType dir, int net_id, Bound& bound);
     bool smaller_than_lower_bound(const Monotonic_element& m, Bound& bound);
     bool direction_congestion(Coordinate_2d pre, int net_id, int distance, Coordinate_2d c, Monotonic_element& vertical_element, Bound& bound);
 };
@@ -11,11 +11,13 @@
 #include <algorithm>
 #include <cstddef>
 #include <limits>
+#include <sstream>
 #include <utility>
 
 #include "../grdb/EdgePlane.h"
 #include "../grdb/plane.h"
 #include "../grdb/RoutingRegion.h"
+#include "../misc/ThreadPool.h"
 #include "../spdlog/spdlog.h"
 
 namespace NTHUR {
@@ -70,11 +72,29 @@ OutputGeneration::Comb OutputGeneration::combAllNet() const {
     return comb;
 }
 
-void OutputGeneration::generate_all_output(std::ostream & output) const {
+//The nets are formatted by blocks in parallel, a few blocks at a time,
+//and written in the net order.
+void OutputGeneration::generate_all_output(std::ostream & output, ThreadPool& pool) const {
 
+    constexpr int NETS_PER_BLOCK = 256;
     const Comb comb = combAllNet();
-    for (uint32_t i = 0; i < comb.size(); ++i) {
-        generate_output(i, comb[i], output);
+    int blocks = (comb.size() + NETS_PER_BLOCK - 1) / NETS_PER_BLOCK;
+    std::vector<std::string> text(std::min(blocks, 4 * pool.size()));
+
+    for (int first = 0; first < blocks; first += text.size()) {
+        int num = std::min<int>(text.size(), blocks - first);
+        pool.parallel_for("output", num, [&](int b, int) {
+            std::ostringstream block;
+            std::size_t begin = (first + b) * NETS_PER_BLOCK;
+            std::size_t end = std::min(begin + NETS_PER_BLOCK, comb.size());
+            for (std::size_t i = begin; i < end; ++i) {
+                generate_output(i, comb[i], block);
+            }
+            text[b] = block.str();
+        });
+        for (int b = 0; b < num; ++b) {
+            output << text[b];
+        }
     }
 
 }
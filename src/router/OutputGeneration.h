@@ -25,6 +25,7 @@ class logger;
 
 namespace NTHUR {
 class RoutingRegion;
+class ThreadPool;
 } /* namespace NTHUR */
 
 namespace NTHUR {
@@ -67,7 +68,7 @@ public:
     void collectComb(Coordinate_3d c2, Coordinate_3d& c, Comb& comb) const;
     void plotNet(int net_id) const;
     void printEdge(const Coordinate_3d& c, const Coordinate_3d& c2) const;
-    void generate_all_output(std::ostream & output) const;
+    void generate_all_output(std::ostream & output, ThreadPool& pool) const;
     void print_max_overflow() const;
     void calculate_wirelength(const int global_via_cost) const;
 
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <vector>
 
+#include "../grdb/RoutingRegion.h"
 #include "../misc/geometry.h"
 #include "Congestion.h"
 #include "Construct_2d_tree.h"
@@ -26,6 +27,9 @@ void Post_processing::initial_for_post_processing() {
 
     vector<COUNTER> counter(construct_2d_tree.two_pin_list.size());
 
+    //Only the 2-pin nets passing an overflowed edge have overflow. The congestion map keeps
+    //the overflowed edges, and every edge the 2-pin nets passing it, so their paths are not walked.
+    const bool indexed = congestion.totals_valid && congestion.two_pins_indexed;
     for (int i = construct_2d_tree.two_pin_list.size() - 1; i >= 0; --i) {
 
         Two_pin_element_2d& twopList = construct_2d_tree.two_pin_list[i];
@@ -33,6 +37,9 @@ void Post_processing::initial_for_post_processing() {
         counter[i].id = i;
         counter[i].total_overflow = 0;
         counter[i].bsize = abs(twopList.pin1.x - twopList.pin2.x) + abs(twopList.pin1.y - twopList.pin2.y);
+        if (indexed) {
+            continue;
+        }
         for (int j = twopList.path.size() - 1; j > 0; --j) {
 
             Edge_2d& edge = congestion.congestionMap2d.edge(twopList.path[j - 1], twopList.path[j]);
@@ -44,6 +51,15 @@ void Post_processing::initial_for_post_processing() {
             total_no_overflow = false;
         }
     }
+    if (indexed) {
+        const Edge_2d* edges = congestion.congestionMap2d.all().begin();
+        for (int e : congestion.overflowed_edges) {
+            for (int id : congestion.edge_two_pins[e]) {
+                counter[id].total_overflow += edges[e].overUsage();
+                total_no_overflow = false;
+            }
+        }
+    }
 
     if (total_no_overflow) {
         return;
@@ -56,6 +72,9 @@ void Post_processing::initial_for_post_processing() {
         int id = counter[i].id;
         Two_pin_element_2d& twopList = construct_2d_tree.two_pin_list[id];
         // call maze routing
+        if (construct_2d_tree.expired()) {
+            break;
+        }
         if (counter[i].total_overflow > 0) {
             rangeRouter.range_router(twopList, 3);
         }
@@ -73,7 +92,7 @@ Post_processing::Post_processing(const RoutingParameters& routingparam, Congesti
     log_sp = spdlog::get("NTHUR");
 }
 
-void Post_processing::process(Route_2pinnets& route_2pinnets) {
+void Post_processing::process(Route_2pinnets& route_2pinnets, Checkpoint& checkpoint, const Checkpoint::Position& position) {
 
     //Fetch from routing_parameter 
     log_sp->info("================================================================");    //
@@ -81,30 +100,47 @@ void Post_processing::process(Route_2pinnets& route_2pinnets) {
     log_sp->info("================================================================");
 
     int Post_processing_iteration = routing_parameter.get_iteration_p3();
-
-    construct_2d_tree.BOXSIZE_INC = routing_parameter.get_init_box_size_p3();
     int inc_num = routing_parameter.get_box_size_inc_p3();
-    SPDLOG_TRACE(log_sp, "size: ({} {}) ", construct_2d_tree.BOXSIZE_INC, inc_num);
+    int first_iteration = 0;
+    int cur_overflow;
 
-    construct_2d_tree.done_iter++;
     congestion.used_cost_flag = MADEOF_COST;
-    int cur_overflow = congestion.cal_max_overflow();
+    if (position.stage == Checkpoint::REFINEMENT) {
+        //the box size, the counters and the costs come from the checkpoint
+        first_iteration = position.iteration;
+        cur_overflow = congestion.total_overflow;
+    } else {
+        construct_2d_tree.BOXSIZE_INC = routing_parameter.get_init_box_size_p3();
+        SPDLOG_TRACE(log_sp, "size: ({} {}) ", construct_2d_tree.BOXSIZE_INC, inc_num);
+
+        construct_2d_tree.done_iter++;
+        cur_overflow = congestion.cal_max_overflow();
+        if (cur_overflow > 0) {
+            //In post processing, we only need to pre-evaluate all cost once.
+            //The other update will be done by update_add(remove)_edge
+            congestion.pre_evaluate_congestion_cost();
+        }
+    }
     if (cur_overflow > 0) {
-        //In post processing, we only need to pre-evaluate all cost once.
-        //The other update will be done by update_add(remove)_edge
-        congestion.pre_evaluate_congestion_cost();
-        for (int i = 0; i < Post_processing_iteration; ++i, ++construct_2d_tree.done_iter) {
+        congestion.index_two_pins(construct_2d_tree.two_pin_list);
+        for (int i = first_iteration; i < Post_processing_iteration; ++i, ++construct_2d_tree.done_iter) {
+            checkpoint.save(i, Checkpoint::Position { Checkpoint::REFINEMENT, i }, construct_2d_tree);
             log_sp->info(" Iteration:  {}", i + 1);
 
             total_no_overflow = true;
 
             initial_for_post_processing();
 
-            cur_overflow = congestion.cal_max_overflow();
-            congestion.cal_total_wirelength();
+            cur_overflow = congestion.report_max_overflow();
+            congestion.report_total_wirelength();
 
             if (total_no_overflow || cur_overflow == 0)
                 break;
+            if (construct_2d_tree.expired()) {
+                log_sp->info(" Iteration:  {} time limit reached", i + 1);
+                break;
+            }
+            construct_2d_tree.keep_best(cur_overflow);
             construct_2d_tree.BOXSIZE_INC += inc_num;
             route_2pinnets.reallocate_two_pin_list();
         }
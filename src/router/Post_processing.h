@@ -3,6 +3,8 @@
 
 #include <memory>
 
+#include "Checkpoint.h"
+
 namespace spdlog {
 class logger;
 } /* namespace spdlog */
@@ -36,7 +38,8 @@ struct Post_processing {
     std::shared_ptr<spdlog::logger> log_sp;
     void initial_for_post_processing();
     Post_processing(const RoutingParameters& routingparam, Congestion& congestion, Construct_2d_tree& construct_2d_tree, RangeRouter& rangeRouter);
-    void process(Route_2pinnets& route_2pinnets);
+    ///@brief Run the post processing, from the start or from a checkpoint of the refinement stage
+    void process(Route_2pinnets& route_2pinnets, Checkpoint& checkpoint, const Checkpoint::Position& position);
 };
 } // namespace NTHUR
 
@@ -6,6 +6,7 @@
 
 #include "../grdb/EdgePlane.h"
 #include "../grdb/RoutingRegion.h"
+#include "CoarseGrid.h"
 #include "Congestion.h"
 #include "Construct_2d_tree.h"
 #include "MM_mazeroute.h"
@@ -23,7 +24,7 @@ bool NTHUR::RangeRouter::double_equal(double a, double b) {
 
 /*sort grid_edge in decending order*/
 bool NTHUR::RangeRouter::comp_grid_edge(const Grid_edge_element& a, const Grid_edge_element& b) {
-    return congestion.congestionMap2d.edge(a.grid, a.c2).congestion() > congestion.congestionMap2d.edge(b.grid, b.c2).congestion();
+    return a.congestion > b.congestion;
 }
 
 /*
@@ -59,32 +60,60 @@ std::string NTHUR::RangeRouter::print_interval() const {
     return s;
 }
 
-void NTHUR::RangeRouter::insert_to_interval(Coordinate_2d coor_2d, Coordinate_2d c2) {
+void NTHUR::RangeRouter::insert_to_interval(Coordinate_2d coor_2d, Coordinate_2d c2, std::vector<std::pair<int, Grid_edge_element> >& edges) {
     double cong_value = congestion.congestionMap2d.edge(coor_2d, c2).congestion();
     if (cong_value > 1) {
         for (int i = interval_list.size() - 1; i >= 0; --i) {
-            Interval_element& ele = interval_list[i];
+            const Interval_element& ele = interval_list[i];
             if (((cong_value < ele.begin_value) || double_equal(cong_value, ele.begin_value)) && //
                     cong_value > ele.end_value) {
-                ele.grid_edge_vector.push_back(Grid_edge_element(coor_2d, c2));
+                edges.emplace_back(i, Grid_edge_element(coor_2d, c2));
                 return;
             }
         }
     }
 }
 
+//Only the overflowed edges can be congested. When the congestion map keeps their index, the
+//horizontal then the vertical ones are taken from it, in the order of the scan of the map.
+//Otherwise the lines of edges are sorted out concurrently, then appended to the intervals in order.
 void NTHUR::RangeRouter::divide_grid_edge_into_interval() {
 
-    for (int i = 0; i < congestion.congestionMap2d.getXSize() - 1; ++i) {
-        for (int j = 0; j < congestion.congestionMap2d.getYSize(); ++j) {
-            insert_to_interval(Coordinate_2d { i, j }, Coordinate_2d { i + 1, j });
+    const int xSize = congestion.congestionMap2d.getXSize();
+    const int ySize = congestion.congestionMap2d.getYSize();
+    if (congestion.totals_valid) {
+        std::vector<std::pair<int, Grid_edge_element> > edges;
+        for (bool horizontal : { true, false }) {
+            for (int e : congestion.sort_overflowed_edges()) {
+                std::pair<Coordinate_2d, Coordinate_2d> c = congestion.congestionMap2d.vertices(e);
+                if ((c.first.y == c.second.y) == horizontal && c.second.x < xSize && c.second.y < ySize) {
+                    insert_to_interval(c.first, c.second, edges);
+                }
+            }
+        }
+        for (const std::pair<int, Grid_edge_element>& edge : edges) {
+            interval_list[edge.first].grid_edge_vector.push_back(edge.second);
         }
+        return;
     }
-    for (int i = 0; i < congestion.congestionMap2d.getXSize(); ++i) {
-        for (int j = 0; j < congestion.congestionMap2d.getYSize() - 1; ++j) {
-            insert_to_interval(Coordinate_2d { i, j }, Coordinate_2d { i, j + 1 });
+    std::vector<std::vector<std::pair<int, Grid_edge_element> > > lines(2 * xSize - 1);
+    construct_2d_tree.pool.parallel_for("edge intervals", lines.size(), [&](int line, int) {
+        if (line < xSize - 1) {
+            int i = line;
+            for (int j = 0; j < ySize; ++j) {
+                insert_to_interval(Coordinate_2d { i, j }, Coordinate_2d { i + 1, j }, lines[line]);
+            }
+        } else {
+            int i = line - (xSize - 1);
+            for (int j = 0; j < ySize - 1; ++j) {
+                insert_to_interval(Coordinate_2d { i, j }, Coordinate_2d { i, j + 1 }, lines[line]);
+            }
+        }
+    });
+    for (const std::vector<std::pair<int, Grid_edge_element> >& edges : lines) {
+        for (const std::pair<int, Grid_edge_element>& edge : edges) {
+            interval_list[edge.first].grid_edge_vector.push_back(edge.second);
         }
-
     }
 
 }
@@ -198,46 +227,79 @@ std::string NTHUR::RangeRouter::printIfBound(const Rectangle& r, const Rectangle
 //If there is no overflowed path by using the two methods above, then remain 
 //the original path.
 void NTHUR::RangeRouter::range_router(Two_pin_element_2d& two_pin, int version) {
-    if (!congestion.check_path_no_overflow(two_pin.path, two_pin.net_id, false)) {
-        ++total_twopin;
-
-        construct_2d_tree.NetDirtyBit[two_pin.net_id] = true;
-
-        congestion.update_congestion_map_remove_two_pin_net(two_pin.path, two_pin.net_id);
+    range_router(two_pin, version, monotonicRouter, construct_2d_tree.mazeroute_in_range, corridor);
+}
 
-        std::vector<Coordinate_2d> bound_path(two_pin.path);
+void NTHUR::RangeRouter::range_router(Two_pin_element_2d& two_pin, int version, MonotonicRouting& monotonicRouter, Multisource_multisink_mazeroute& mazeroute,
+        Corridor& corridor) {
+    if (rip_up(two_pin, version)) {
+        reroute(two_pin, version, monotonicRouter, mazeroute, corridor, true);
+        congestion.update_congestion_map_insert_two_pin_net(two_pin);
+    }
+}
 
-        Bound bound;
-        bool find_path_flag = monotonicRouter.monotonicRoute(two_pin, bound, bound_path);
+//Remove the path of the 2-pin net from the congestion map if it passes any
+//overflowed edge. Return false if the path is kept.
+bool NTHUR::RangeRouter::rip_up(Two_pin_element_2d& two_pin, int version) {
+    if (congestion.check_path_no_overflow(two_pin.path, two_pin.net_id, false)) {
+        return false;
+    }
+    ++total_twopin;
 
-        if (version == 2) {
-            two_pin.done = construct_2d_tree.done_iter;
-        }
-        if ((find_path_flag == false) || !congestion.check_path_no_overflow(bound_path, two_pin.net_id, true)) {
-            Coordinate_2d start;
-            Coordinate_2d end;
+    construct_2d_tree.NetDirtyBit[two_pin.net_id] = true;
 
-            start.x = min(two_pin.pin1.x, two_pin.pin2.x);
-            start.y = min(two_pin.pin1.y, two_pin.pin2.y);
-            end.x = max(two_pin.pin1.x, two_pin.pin2.x);
-            end.y = max(two_pin.pin1.y, two_pin.pin2.y);
+    congestion.update_congestion_map_remove_two_pin_net(two_pin.path, two_pin.net_id, two_pin.id);
 
-            int size = construct_2d_tree.BOXSIZE_INC;
-            start.x = max(0, start.x - size);
-            start.y = max(0, start.y - size);
-            end.x = min(construct_2d_tree.rr_map.get_gridx() - 1, end.x + size);
-            end.y = min(construct_2d_tree.rr_map.get_gridy() - 1, end.y + size);
+    if (version == 2) {
+        two_pin.done = construct_2d_tree.done_iter;
+    }
+    return true;
+}
 
-            find_path_flag = construct_2d_tree.mazeroute_in_range.mm_maze_route_p(two_pin, bound.cost, bound.distance, bound.via_num, start, end, version);
+//Window of the maze routing of a 2-pin net
+void NTHUR::RangeRouter::routing_window(const Two_pin_element_2d& two_pin, Coordinate_2d& start, Coordinate_2d& end) const {
+    start.x = min(two_pin.pin1.x, two_pin.pin2.x);
+    start.y = min(two_pin.pin1.y, two_pin.pin2.y);
+    end.x = max(two_pin.pin1.x, two_pin.pin2.x);
+    end.y = max(two_pin.pin1.y, two_pin.pin2.y);
+
+    int size = construct_2d_tree.BOXSIZE_INC;
+    start.x = max(0, start.x - size);
+    start.y = max(0, start.y - size);
+    end.x = min(construct_2d_tree.rr_map.get_gridx() - 1, end.x + size);
+    end.y = min(construct_2d_tree.rr_map.get_gridy() - 1, end.y + size);
+}
 
-            if (find_path_flag == false) {
-                two_pin.path.insert(two_pin.path.begin(), bound_path.begin(), bound_path.end());
-            }
+//Find a new path for a ripped-up 2-pin net, without inserting it in the congestion map.
+//Return true if the path was found by the maze router: without adjust, the net tree
+//still has to be updated with Multisource_multisink_mazeroute::adjust_twopin_element.
+bool NTHUR::RangeRouter::reroute(Two_pin_element_2d& two_pin, int version, MonotonicRouting& monotonicRouter, Multisource_multisink_mazeroute& mazeroute,
+        Corridor& corridor, bool adjust) {
+    std::vector<Coordinate_2d> bound_path(two_pin.path);
+
+    Bound bound;
+    bool find_path_flag = monotonicRouter.monotonicRoute(two_pin, bound, bound_path);
+
+    if ((find_path_flag == false) || !congestion.check_path_no_overflow(bound_path, two_pin.net_id, true)) {
+        Coordinate_2d start;
+        Coordinate_2d end;
+        routing_window(two_pin, start, end);
+
+        //long connections are only searched inside their coarse corridor
+        const Corridor* inCorridor = nullptr;
+        if (congestion.coarseGrid && congestion.coarseGrid->useCorridor(start, end)) {
+            congestion.coarseGrid->corridor(two_pin.net_id, two_pin.pin1, two_pin.pin2, start, end, corridor);
+            inCorridor = &corridor;
         }
 
-        congestion.update_congestion_map_insert_two_pin_net(two_pin);
+        find_path_flag = mazeroute.mm_maze_route_p(two_pin, bound.cost, bound.distance, bound.via_num, start, end, version, inCorridor, adjust);
 
+        if (find_path_flag == false) {
+            two_pin.path.insert(two_pin.path.begin(), bound_path.begin(), bound_path.end());
+        }
+        return find_path_flag;
     }
+    return false;
 }
 
 void NTHUR::RangeRouter::query_range_2pin(const Rectangle& r, //
@@ -250,7 +312,7 @@ void NTHUR::RangeRouter::query_range_2pin(const Rectangle& r, //
             Point_fc& cell = (gridCell[x][y]);
 
             for (Two_pin_element_2d* twopin : cell.points) {   //for each pin or steiner point
-                if (twopin->done != construct_2d_tree.done_iter) {
+                if (twopin->done != construct_2d_tree.done_iter && in_scope(twopin->net_id)) {
                     Coordinate_2d& p1 = twopin->pin1;
                     Coordinate_2d& p2 = twopin->pin2;
                     if (colorMap[p1.x][p1.y].routeState != done_counter && //
@@ -278,10 +340,15 @@ void NTHUR::RangeRouter::specify_all_range(boost::multi_array<Point_fc, 2>& grid
     }
 
     total_twopin = 0;
+    speculated = 0;
+    conflicts = 0;
 
     for (int i = interval_list.size() - 1; i >= 0; --i) {
         Interval_element& ele = interval_list[i];
         range_vector.clear();
+        for (Grid_edge_element& gridEdge : ele.grid_edge_vector) {
+            gridEdge.congestion = congestion.congestionMap2d.edge(gridEdge.grid, gridEdge.c2).congestion();
+        }
         sort(ele.grid_edge_vector.begin(), ele.grid_edge_vector.end(), [&](const Grid_edge_element& a, const Grid_edge_element& b) {
             return comp_grid_edge( a, b);
         });
@@ -307,38 +374,264 @@ void NTHUR::RangeRouter::specify_all_range(boost::multi_array<Point_fc, 2>& grid
         sort(twopin_list.begin(), twopin_list.end(), [&](const Two_pin_element_2d *a, const Two_pin_element_2d *b) {
             return Two_pin_element_2d::comp_stn_2pin(*a,*b);});
 
-        for (Two_pin_element_2d * two_pin : twopin_list) {
-
-            range_router(*two_pin, 2);
-
-        }
+        route_twopin_list(twopin_list);
     }
 
     twopin_list.clear();
     int length = construct_2d_tree.two_pin_list.size();
     for (int i = 0; i < length; ++i) {
-        if (construct_2d_tree.two_pin_list[i].done != construct_2d_tree.done_iter) {
+        if (construct_2d_tree.two_pin_list[i].done != construct_2d_tree.done_iter && in_scope(construct_2d_tree.two_pin_list[i].net_id)) {
             twopin_list.push_back(&construct_2d_tree.two_pin_list[i]);
         }
     }
 
     sort(twopin_list.begin(), twopin_list.end(), [&](const Two_pin_element_2d *a, const Two_pin_element_2d *b) {
         return Two_pin_element_2d::comp_stn_2pin(*a,*b);});
-    for (int i = 0; i < (int) twopin_list.size(); ++i) {
-        if (twopin_list[i]->boxSize() == 1)
+    auto last = std::find_if(twopin_list.begin(), twopin_list.end(), [](const Two_pin_element_2d *a) {
+        return a->boxSize() == 1;});
+    twopin_list.erase(last, twopin_list.end());
+    route_twopin_list(twopin_list);
+
+    if (congestion.coarseGrid) {
+        congestion.coarseGrid->logStatistic();
+    }
+    if (pool && batch_size > 0) {
+        log_sp->info("optimistic reroute: {} routed, {} conflicts ({:.2f}%)", speculated, conflicts, speculated ? 100. * conflicts / speculated : 0.);
+    }
+}
+
+//Route the 2-pin nets of the list in the list order, see route_waves and
+//route_optimistic for the parallel modes. Once the time limit expires, the
+//remaining 2-pin nets, waves or batches are left as they are.
+void NTHUR::RangeRouter::route_twopin_list(const std::vector<Two_pin_element_2d*>& twopin_list) {
+    if (!pool) {
+        for (Two_pin_element_2d* two_pin : twopin_list) {
+            if (construct_2d_tree.expired()) {
+                break;
+            }
+            range_router(*two_pin, 2);
+        }
+    } else if (batch_size > 0) {
+        route_optimistic(twopin_list);
+    } else {
+        route_waves(twopin_list);
+    }
+}
+
+//The footprint of a 2-pin net is everything range_router may read or write:
+//its routing window and the extent of the whole routed net, which the maze
+//router walks. It is computed once per list for all the 2-pin nets of a net,
+//and new paths stay inside it.
+void NTHUR::RangeRouter::compute_footprints(const std::vector<Two_pin_element_2d*>& twopin_list) {
+    ++footprint_stamp;
+    Rectangle bound { Coordinate_2d { 0, 0 }, congestion.congestionMap2d.getSize() + Coordinate_2d { -1, -1 } };
+    for (Two_pin_element_2d* two_pin : twopin_list) {
+        Rectangle window { two_pin->pin1, two_pin->pin2 };
+        window.expand(construct_2d_tree.BOXSIZE_INC);
+        bound.clip(window);
+        if (net_stamp[two_pin->net_id] != footprint_stamp) {
+            net_stamp[two_pin->net_id] = footprint_stamp;
+            net_footprint[two_pin->net_id] = window;
+        } else {
+            net_footprint[two_pin->net_id].extend(window.upLeft);
+            net_footprint[two_pin->net_id].extend(window.downRight);
+        }
+    }
+    for (const Two_pin_element_2d& two_pin : construct_2d_tree.two_pin_list) {
+        if (net_stamp[two_pin.net_id] == footprint_stamp) {
+            Rectangle& r = net_footprint[two_pin.net_id];
+            r.extend(two_pin.pin1);
+            r.extend(two_pin.pin2);
+            for (const Coordinate_2d& c : two_pin.path) {
+                r.extend(c);
+            }
+        }
+    }
+}
+
+//The list is cut into waves of 2-pin nets that are routed concurrently.
+//A 2-pin net goes in the wave following the last wave whose footprints
+//overlap its own, so overlapping 2-pin nets keep the list order, the others
+//touch disjoint edges, and the result is the same as the sequential one.
+void NTHUR::RangeRouter::route_waves(const std::vector<Two_pin_element_2d*>& twopin_list) {
+    compute_footprints(twopin_list);
+
+    std::fill(tile_wave.data(), tile_wave.data() + tile_wave.num_elements(), 0);
+    for (std::vector<Two_pin_element_2d*>& wave : waves) {
+        wave.clear();
+    }
+    for (Two_pin_element_2d* two_pin : twopin_list) {
+        const Rectangle& r = net_footprint[two_pin->net_id];
+        int wave = 0;
+        for (int x = r.upLeft.x / footprint_tile; x <= r.downRight.x / footprint_tile; ++x) {
+            for (int y = r.upLeft.y / footprint_tile; y <= r.downRight.y / footprint_tile; ++y) {
+                wave = std::max(wave, tile_wave[x][y]);
+            }
+        }
+        for (int x = r.upLeft.x / footprint_tile; x <= r.downRight.x / footprint_tile; ++x) {
+            for (int y = r.upLeft.y / footprint_tile; y <= r.downRight.y / footprint_tile; ++y) {
+                tile_wave[x][y] = wave + 1;
+            }
+        }
+        if ((int) waves.size() <= wave) {
+            waves.resize(wave + 1);
+        }
+        waves[wave].push_back(two_pin);
+    }
+
+    for (std::vector<Two_pin_element_2d*>& wave : waves) {
+        if (construct_2d_tree.expired()) {
             break;
-        range_router(*twopin_list[i], 2);
+        }
+        pool->parallel_for("reroute wave", wave.size(), [&](int i, int worker) {
+            if (worker == 0) {
+                range_router(*wave[i], 2);
+            } else {
+                Worker& w = *workers[worker - 1];
+                range_router(*wave[i], 2, w.monotonicRouter, w.mazeroute, w.corridor);
+            }
+        });
     }
+}
+
+//The list is routed in batches of at most batch_size ripped-up 2-pin nets,
+//one per net. The batch is ripped up in list order, then every 2-pin net is
+//routed concurrently on a copy against the same congestion map, and the copies
+//are committed in list order. The result only depends on batch_size.
+void NTHUR::RangeRouter::route_optimistic(const std::vector<Two_pin_element_2d*>& twopin_list) {
+    std::size_t next = 0;
+    while (next < twopin_list.size() && !construct_2d_tree.expired()) {
+        ++batch_stamp;
+        int num = 0;
+        for (; next < twopin_list.size() && num < batch_size; ++next) {
+            Two_pin_element_2d* two_pin = twopin_list[next];
+            if (net_batch[two_pin->net_id] == batch_stamp) {
+                break;
+            }
+            if (rip_up(*two_pin, 2)) {
+                net_batch[two_pin->net_id] = batch_stamp;
+                if ((int) batch.size() <= num) {
+                    batch.emplace_back();
+                }
+                batch[num++].two_pin = two_pin;
+            }
+        }
+
+        pool->parallel_for("reroute batch", num, [&](int i, int worker) {
+            Speculation& s = batch[i];
+            s.route = *s.two_pin;
+            s.expanded.clear();
+            MonotonicRouting& monotonic = worker == 0 ? monotonicRouter : workers[worker - 1]->monotonicRouter;
+            Multisource_multisink_mazeroute& mazeroute = worker == 0 ? construct_2d_tree.mazeroute_in_range : workers[worker - 1]->mazeroute;
+            Corridor& inCorridor = worker == 0 ? corridor : workers[worker - 1]->corridor;
+            mazeroute.record_expanded(&s.expanded);
+            s.maze = reroute(s.route, 2, monotonic, mazeroute, inCorridor, false);
+            mazeroute.record_expanded(nullptr);
+        });
+
+        batch_cells.clear();
+        for (int i = 0; i < num; ++i) {
+            commit(batch[i]);
+        }
+        speculated += num;
+    }
+}
+
+//A copy is kept if no path committed before it in the batch changed an edge its
+//search read: it is then the route a search done now would find. Otherwise the
+//2-pin net is routed again. The monotonic routing reads the bounding box of the
+//pins, the maze router the edges around the GCells it expanded, and the coarse
+//corridor the supertiles overlapping the maze routing window.
+void NTHUR::RangeRouter::commit(Speculation& s) {
+    Two_pin_element_2d& two_pin = *s.two_pin;
+    Rectangle box { two_pin.pin1, two_pin.pin2 };
+    Rectangle tiles { box };
+    bool coarse = false;
+    if (congestion.coarseGrid && !s.expanded.empty()) {
+        routing_window(two_pin, tiles.upLeft, tiles.downRight);
+        if (congestion.coarseGrid->useCorridor(tiles.upLeft, tiles.downRight)) {
+            int tile = congestion.coarseGrid->tileSize;
+            tiles.upLeft.set(tiles.upLeft.x / tile * tile, tiles.upLeft.y / tile * tile);
+            tiles.downRight.set(std::min(construct_2d_tree.rr_map.get_gridx() - 1, (tiles.downRight.x / tile + 1) * tile - 1), //
+                    std::min(construct_2d_tree.rr_map.get_gridy() - 1, (tiles.downRight.y / tile + 1) * tile - 1));
+            coarse = true;
+        }
+    }
+    ++read_stamp;
+    for (const Coordinate_2d& c : s.expanded) {
+        read_mark[c.x][c.y] = read_stamp;
+    }
+    bool conflict = std::any_of(batch_cells.begin(), batch_cells.end(), [&](const Coordinate_2d& c) {
+        return box.contains(c) || read_mark[c.x][c.y] == read_stamp || (coarse && tiles.contains(c));
+    });
+
+    if (conflict) {
+        ++conflicts;
+        reroute(two_pin, 2, monotonicRouter, construct_2d_tree.mazeroute_in_range, corridor, true);
+    } else if (s.maze) {
+        NetTree& tree = construct_2d_tree.net_tree[two_pin.net_id];
+        int pin1_v = tree.find(two_pin.pin1);
+        int pin2_v = tree.find(two_pin.pin2);
+        two_pin.path.swap(s.route.path);
+        Multisource_multisink_mazeroute::adjust_twopin_element(two_pin, tree, pin1_v, pin2_v);
+    } else {
+        two_pin.path.swap(s.route.path);
+    }
+
+    congestion.update_congestion_map_insert_two_pin_net(two_pin);
+    batch_cells.insert(batch_cells.end(), two_pin.path.begin(), two_pin.path.end());
+}
+
+//batch > 0 selects the optimistic mode. Unless deterministic, a batch holds
+//batch 2-pin nets per thread and the result depends on the thread count.
+void NTHUR::RangeRouter::enable_parallel(ThreadPool& threadPool, int batch, bool deterministic) {
+    pool = &threadPool;
+    int threads = pool->size();
+    batch_size = deterministic ? batch : batch * threads;
+    workers.clear();
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(new Worker(construct_2d_tree, congestion, monotonic_enable, wavefront_max_cells));
+    }
+
+    //footprints are aligned on the supertiles so that concurrent routes never share a coarse edge
+    footprint_tile = congestion.coarseGrid ? congestion.coarseGrid->tileSize : PARALLEL_TILE_SIZE;
+    tile_wave.resize(boost::extents[(congestion.congestionMap2d.getXSize() + footprint_tile - 1) / footprint_tile] //
+    [(congestion.congestionMap2d.getYSize() + footprint_tile - 1) / footprint_tile]);
+    net_stamp.assign(construct_2d_tree.rr_map.get_netNumber(), 0);
+    net_batch.assign(construct_2d_tree.rr_map.get_netNumber(), 0);
+    read_mark.resize(boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()]);
+    std::fill(read_mark.data(), read_mark.data() + read_mark.num_elements(), 0);
+    net_footprint.assign(construct_2d_tree.rr_map.get_netNumber(), Rectangle { Coordinate_2d { 0, 0 }, Coordinate_2d { 0, 0 } });
+
+    if (batch_size > 0) {
+        log_sp->info("optimistic rip-up and reroute with {} threads, batches of {} 2-pin nets", threads, batch_size);
+    } else {
+        log_sp->info("parallel rip-up and reroute with {} threads", threads);
+    }
+}
 
-    construct_2d_tree.mazeroute_in_range.clear_net_tree();
+NTHUR::RangeRouter::Worker::Worker(Construct_2d_tree& construct_2d_tree, Congestion& congestion, bool monotonic_enable, int wavefront_max_cells) :
+        monotonicRouter { congestion, monotonic_enable, wavefront_max_cells }, //
+        mazeroute { construct_2d_tree, congestion } {
 }
 
-NTHUR::RangeRouter::RangeRouter(Construct_2d_tree& construct2dTree, Congestion& congestion, bool monotonic_enable) :
+NTHUR::RangeRouter::RangeRouter(Construct_2d_tree& construct2dTree, Congestion& congestion, bool monotonic_enable, int wavefront_max_cells) :
         total_twopin(0),	//
 
         construct_2d_tree { construct2dTree }, //
         congestion { congestion }, //
-        colorMap { boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()] }, monotonicRouter { congestion, monotonic_enable } {
+        colorMap { boost::extents[congestion.congestionMap2d.getXSize()][congestion.congestionMap2d.getYSize()] }, //
+        monotonic_enable { monotonic_enable }, //
+        wavefront_max_cells { wavefront_max_cells }, //
+        monotonicRouter { congestion, monotonic_enable, wavefront_max_cells }, //
+        pool { }, //
+        batch_size { 0 }, //
+        speculated { 0 }, //
+        conflicts { 0 }, //
+        footprint_tile { PARALLEL_TILE_SIZE }, //
+        footprint_stamp { 0 }, //
+        batch_stamp { 0 }, //
+        read_stamp { 0 } {
     log_sp = spdlog::get("NTHUR");
 
 }
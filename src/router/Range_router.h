@@ -5,13 +5,18 @@
 
 #include <boost/multi_array.hpp>
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "../misc/geometry.h"
+#include "../misc/ThreadPool.h"
+#include "CoarseGrid.h"
 #include "DataDef.h"
+#include "MM_mazeroute.h"
 #include "MonotonicRouting.h"
 #include "Route_2pinnets.h"
 
@@ -24,6 +29,7 @@ namespace NTHUR {
 constexpr int INTERVAL_NUM = 10;
 constexpr int EXPAND_RANGE_SIZE = 10;
 constexpr int EXPAND_RANGE_INC = 1;
+constexpr int PARALLEL_TILE_SIZE = 8;   //granularity of the footprint overlap test of the parallel mode
 
 class Congestion;
 
@@ -35,10 +41,11 @@ class Grid_edge_element {
 public:
     Coordinate_2d grid;
     Coordinate_2d c2;
+    double congestion;  //sort key, read from the map just before sorting
 
 public:
     Grid_edge_element(Coordinate_2d& grid, Coordinate_2d& c2) :
-            grid(grid), c2 { c2 } {
+            grid(grid), c2 { c2 }, congestion { 0 } {
     }
 };
 class Interval_element {
@@ -73,36 +80,90 @@ public:
         }
     };
 
+    //2-pin net of an optimistic batch, routed on a copy until it is committed
+    struct Speculation {
+        Two_pin_element_2d* two_pin;
+        Two_pin_element_2d route;
+        bool maze;      //path found by the maze router, net tree not adjusted yet
+        std::vector<Coordinate_2d> expanded;    //GCells expanded by the maze router
+    };
+
+    //Routing state of one extra thread of the parallel mode
+    struct Worker {
+        MonotonicRouting monotonicRouter;
+        Multisource_multisink_mazeroute mazeroute;
+        Corridor corridor;
+
+        Worker(Construct_2d_tree& construct_2d_tree, Congestion& congestion, bool monotonic_enable, int wavefront_max_cells);
+    };
+
     std::vector<Rectangle> range_vector;
     std::array<Interval_element, INTERVAL_NUM> interval_list;
 
-    int total_twopin = 0;
+    std::atomic<int> total_twopin;
 
     Construct_2d_tree& construct_2d_tree;
     Congestion& congestion;
     boost::multi_array<ColorMap, 2> colorMap;
+    bool monotonic_enable;
+    int wavefront_max_cells;
     MonotonicRouting monotonicRouter;
+    Corridor corridor;
+
+    ThreadPool* pool;                       //parallel mode, null when sequential
+    std::vector<std::unique_ptr<Worker> > workers;
+    int batch_size;                         //2-pin nets of an optimistic batch, 0 for the wave mode
+    int speculated;                         //optimistic routes of the current iteration
+    int conflicts;                          //optimistic routes routed again at commit
+    std::vector<char> scope;                //nets the rip-up and reroute may take, by net id, every net if empty
 
     std::shared_ptr<spdlog::logger> log_sp;
 
-    RangeRouter(Construct_2d_tree& construct_2d_tree, Congestion& congestion, bool monotonic_enable);
+    RangeRouter(Construct_2d_tree& construct_2d_tree, Congestion& congestion, bool monotonic_enable, int wavefront_max_cells);
+    void enable_parallel(ThreadPool& pool, int batch, bool deterministic);
     void define_interval();
     void divide_grid_edge_into_interval();
     void specify_all_range(boost::multi_array<Point_fc, 2> & gridCell);
+    bool in_scope(int net_id) const {
+        return scope.empty() || scope[net_id];
+    }
 
     bool double_equal(double a, double b);
     bool comp_grid_edge(const Grid_edge_element& a, const Grid_edge_element& b);
 
-    void insert_to_interval(Coordinate_2d coor_2d, Coordinate_2d c2);
+    void insert_to_interval(Coordinate_2d coor_2d, Coordinate_2d c2, std::vector<std::pair<int, Grid_edge_element> >& edges);
     void walkFrame(const Rectangle& r, std::function<void(Coordinate_2d& i, Coordinate_2d& before)> accumulate);
 
     void expand_range(Coordinate_2d c1, Coordinate_2d c2, int interval_index);
 
     void range_router(Two_pin_element_2d& two_pin, int version);
+    void range_router(Two_pin_element_2d& two_pin, int version, MonotonicRouting& monotonic, Multisource_multisink_mazeroute& mazeroute, Corridor& corridor);
+    bool rip_up(Two_pin_element_2d& two_pin, int version);
+    bool reroute(Two_pin_element_2d& two_pin, int version, MonotonicRouting& monotonic, Multisource_multisink_mazeroute& mazeroute, Corridor& corridor, bool adjust);
+    void route_twopin_list(const std::vector<Two_pin_element_2d*>& twopin_list);
     bool inside_range(int left_x, int bottom_y, int right_x, int top_y, Coordinate_2d& pt);
     void query_range_2pin(const Rectangle& r, std::vector<Two_pin_element_2d*>& twopin_list, boost::multi_array<Point_fc, 2>& gridCell);
 
 private:
+    int footprint_tile;
+    int footprint_stamp;
+    std::vector<int> net_stamp;                 //footprint_stamp of the last footprint of each net
+    std::vector<Rectangle> net_footprint;
+    boost::multi_array<int, 2> tile_wave;      //last wave using each tile
+    std::vector<std::vector<Two_pin_element_2d*> > waves;
+    int batch_stamp;
+    std::vector<int> net_batch;                 //batch_stamp of the last batch of each net
+    std::vector<Speculation> batch;
+    std::vector<Coordinate_2d> batch_cells;     //GCells of the paths committed in the current batch
+    int read_stamp;
+    boost::multi_array<int, 2> read_mark;      //read_stamp of the last commit whose search expanded each GCell
+
+    void routing_window(const Two_pin_element_2d& two_pin, Coordinate_2d& start, Coordinate_2d& end) const;
+    void compute_footprints(const std::vector<Two_pin_element_2d*>& twopin_list);
+    void route_waves(const std::vector<Two_pin_element_2d*>& twopin_list);
+    void route_optimistic(const std::vector<Two_pin_element_2d*>& twopin_list);
+    void commit(Speculation& s);
+
     std::string printIfBound(const Rectangle& r, const Rectangle& bound, const int interval_index, const Coordinate_2d& c1, const Coordinate_2d& c2) const;
     std::string print_interval() const;
 }
@@ -7,6 +7,7 @@
 
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
+#include "../misc/ThreadPool.h"
 #include "Congestion.h"
 #include "Construct_2d_tree.h"
 #include "Layerassignment.h"
@@ -15,7 +16,8 @@
 #define SPDLOG_TRACE_ON
 #include "../spdlog/spdlog.h"
 
-NTHUR::OutputGeneration NTHUR::Route::process(const RoutingRegion& rr, const spdlog::level::level_enum& level) {
+NTHUR::OutputGeneration NTHUR::Route::process(const RoutingRegion& rr, const spdlog::level::level_enum& level, int threads,
+        std::chrono::steady_clock::time_point deadline) {
 
     auto console_sp = spdlog::get("NTHUR");
     if (console_sp == nullptr) {
@@ -29,13 +31,16 @@ NTHUR::OutputGeneration NTHUR::Route::process(const RoutingRegion& rr, const spd
     }
     spdlog::set_level(level);
 
-    Congestion congestion(rr.get_gridx(), rr.get_gridy());
+    ThreadPool pool(threads);
+    Congestion congestion(rr.get_gridx(), rr.get_gridy(), pool);
     RoutingParameters routingparam; // default settings
     routingparam.set_overflow_threshold(0);
-    Construct_2d_tree tree(routingparam, rr, congestion);
+    routingparam.set_threads(threads);
+    routingparam.set_deadline(deadline);
+    Construct_2d_tree tree(routingparam, rr, congestion, pool);
 
     OutputGeneration output(rr);
-    Layer_assignment layerAssignement(congestion, output);
+    Layer_assignment layerAssignement(congestion, output, pool);
 
     return output;
 }
@@ -8,6 +8,7 @@
 #ifndef SRC_ROUTER_ROUTE_H_
 #define SRC_ROUTER_ROUTE_H_
 
+#include <chrono>
 #include <mutex>
 
 #include "../grdb/RoutingRegion.h"
@@ -17,7 +18,9 @@
 namespace NTHUR {
 class Route {
 public:
-    OutputGeneration process(const RoutingRegion& rr, const spdlog::level::level_enum& level = spdlog::level::warn);
+    ///@brief Route rr. Once the deadline is reached, the lowest overflow solution seen so far is output.
+    OutputGeneration process(const RoutingRegion& rr, const spdlog::level::level_enum& level = spdlog::level::warn, int threads = 1,
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
 
 private:
     std::mutex g_mutex;
@@ -18,6 +18,8 @@
 #include "../grdb/EdgePlane.h"
 #include "../grdb/RoutingComponent.h"
 #include "../grdb/RoutingRegion.h"
+#include "../misc/StripedLock.h"
+#include "../misc/ThreadPool.h"
 
 #define SPDLOG_TRACE_ON
 #include "../spdlog/common.h"
@@ -37,12 +39,14 @@ using namespace std;
 Route_2pinnets::Route_2pinnets(Construct_2d_tree& construct_2d_tree, RangeRouter& rangerouter, Congestion& congestion) :
         rr_map { construct_2d_tree.rr_map }, //
         gridcell { boost::extents[rr_map.get_gridx()][rr_map.get_gridy()] }, //
-        colorMap { boost::extents[rr_map.get_gridx()][rr_map.get_gridy()] }, //
         dirTransferTable { 1, 0, 3, 2 }, //
         construct_2d_tree { construct_2d_tree }, //
         rangerouter { rangerouter }, //
         congestion { congestion } {
     log_sp = spdlog::get("NTHUR");
+    for (int i = 0; i < construct_2d_tree.pool.size(); ++i) {
+        colorMaps.emplace_back(boost::extents[rr_map.get_gridx()][rr_map.get_gridy()]);
+    }
 }
 
 void Route_2pinnets::allocate_gridcell() {
@@ -84,24 +88,30 @@ void Route_2pinnets::route_all_2pin_net() {
 
 void Route_2pinnets::reset_c_map_used_net_to_one() {
 
-    for (Edge_2d& edge : congestion.congestionMap2d.all()) {
-        for (auto& routeNetTable : edge.used_net) {
-            edge.used_net[routeNetTable.first] = 1;
+    const int edges = congestion.congestionMap2d.num_elements();
+    const int chunk = 4096;
+    construct_2d_tree.pool.parallel_for("used net reset", (edges + chunk - 1) / chunk, [&](int c, int) {
+        Edge_2d* edge = congestion.congestionMap2d.all().begin();
+        for (int e = c * chunk; e < std::min(edges, (c + 1) * chunk); ++e) {
+            for (auto& routeNetTable : edge[e].used_net) {
+                routeNetTable.second = 1;
+            }
         }
-    }
+    });
 
 }
 
 //set terminal type to c_map_2d
 //void set_c_map_terminal_type(int net_id)
-void Route_2pinnets::put_terminal_color_on_colormap(int net_id) {
+void Route_2pinnets::put_terminal_color_on_colormap(int net_id, boost::multi_array<ColorMap, 2>& colorMap) {
     for (const Net::Pin& pin : rr_map.get_net(net_id).get_pinList()) {
         colorMap[pin.x][pin.y].terminal = net_id;
     }
 }
 
 //return: one-degree terminal, non-one-degree terminal, one-degree nonterminal, steiner point, two-degree (dir)
-Coordinate_2d Route_2pinnets::determine_is_terminal_or_steiner_point(Coordinate_2d& c, Coordinate_2d& head, int net_id, PointType& pointType) {
+Coordinate_2d Route_2pinnets::determine_is_terminal_or_steiner_point(Coordinate_2d& c, Coordinate_2d& head, int net_id, PointType& pointType,
+        const boost::multi_array<ColorMap, 2>& colorMap) {
 
     Coordinate_2d result;
     if (colorMap[c.x][c.y].terminal == net_id) {
@@ -136,10 +146,10 @@ Coordinate_2d Route_2pinnets::determine_is_terminal_or_steiner_point(Coordinate_
     return result;
 }
 
-void Route_2pinnets::add_two_pin(int net_id, std::vector<Coordinate_2d>& path) {
+void Route_2pinnets::add_two_pin(int net_id, std::vector<Coordinate_2d>& path, std::vector<Two_pin_element_2d>& two_pin_list) {
     if (path.size() > 1) {
-        construct_2d_tree.two_pin_list.emplace_back();
-        Two_pin_element_2d& two_pin = construct_2d_tree.two_pin_list.back();
+        two_pin_list.emplace_back();
+        Two_pin_element_2d& two_pin = two_pin_list.back();
         two_pin.pin1 = path.front();
         two_pin.net_id = net_id;
         two_pin.pin2 = path.back();
@@ -149,8 +159,8 @@ void Route_2pinnets::add_two_pin(int net_id, std::vector<Coordinate_2d>& path) {
     }
 }
 
-void Route_2pinnets::fillTree(int offset, int net_id) {
-    int sizeTree = construct_2d_tree.two_pin_list.size() - offset;
+void Route_2pinnets::fillTree(const std::vector<Two_pin_element_2d>& two_pin_list, int net_id) {
+    int sizeTree = two_pin_list.size();
     TreeFlute& tree = construct_2d_tree.net_flutetree[net_id];
 
     tree.branch.resize(sizeTree + 1);
@@ -158,7 +168,7 @@ void Route_2pinnets::fillTree(int offset, int net_id) {
     std::unordered_map<Coordinate_2d, int> indexmap;
     indexmap.reserve(sizeTree + 1);
 
-    Two_pin_element_2d& first_pin = construct_2d_tree.two_pin_list.at(offset);
+    const Two_pin_element_2d& first_pin = two_pin_list.at(0);
     indexmap.emplace(first_pin.pin1, 0);
 
     tree.branch[0].x = first_pin.pin1.x;
@@ -166,7 +176,7 @@ void Route_2pinnets::fillTree(int offset, int net_id) {
     tree.branch[0].n = 0;
 
     for (int i = 1; i < sizeTree + 1; ++i) {
-        Two_pin_element_2d& two_pin = construct_2d_tree.two_pin_list.at(offset + i - 1);
+        const Two_pin_element_2d& two_pin = two_pin_list.at(i - 1);
 
         indexmap.emplace(two_pin.pin2, i);
 
@@ -177,15 +187,20 @@ void Route_2pinnets::fillTree(int offset, int net_id) {
     }
     tree.number = sizeTree + 1;
 
+    // the net topology changed, the maze router rebuilds its view when it needs it
+    construct_2d_tree.net_tree[net_id].clear();
 }
 
-void Route_2pinnets::bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net_id) {
+//The congestion map is only read: the dangling paths are returned in result, the other nets
+//can be decomposed concurrently with their own color map.
+void Route_2pinnets::bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net_id, boost::multi_array<ColorMap, 2>& colorMap, Decomposition& result) {
 
     std::stack<std::vector<Coordinate_2d>> stack;
     stack.emplace();
     stack.top().push_back(start_coor);
 
-    int offset = construct_2d_tree.two_pin_list.size();
+    result.two_pin_list.clear();
+    result.dangling.clear();
 
     while (!stack.empty()) {
         std::vector<Coordinate_2d>& path = stack.top();
@@ -193,7 +208,7 @@ void Route_2pinnets::bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net
         colorMap[c.x][c.y].traverse = net_id;
 
         if (colorMap[c.x][c.y].terminal == net_id) {
-            add_two_pin(net_id, path);
+            add_two_pin(net_id, path, result.two_pin_list);
         }
 
         std::vector<Coordinate_2d> neighbors;
@@ -207,11 +222,13 @@ void Route_2pinnets::bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net
 
         switch (neighbors.size()) {
         case 0:
-            congestion.update_congestion_map_remove_two_pin_net(path, net_id);
+            if (path.size() > 1) {
+                result.dangling.push_back(std::move(path));
+            }
             stack.pop();
             break;
         default:
-            add_two_pin(net_id, path);
+            add_two_pin(net_id, path, result.two_pin_list);
             for (std::size_t i = 1; i < neighbors.size(); ++i) {
                 stack.emplace(path);
                 stack.top().emplace_back(neighbors.at(i));
@@ -222,14 +239,19 @@ void Route_2pinnets::bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net
         }
     }
 
-    fillTree(offset, net_id);
+    fillTree(result.two_pin_list, net_id);
 }
 
+//The dirty nets are decomposed concurrently, then their 2-pin nets are appended
+//in net order and their dangling paths are removed from the congestion map.
 void Route_2pinnets::reallocate_two_pin_list() {
 
-    for (u_int32_t i = 0; i < colorMap.num_elements(); ++i) {
-        colorMap.data()[i].set(-1, -1);
-    }
+    ThreadPool& pool = construct_2d_tree.pool;
+    pool.parallel_for("color map reset", colorMaps.size(), [&](int i, int) {
+        for (u_int32_t j = 0; j < colorMaps[i].num_elements(); ++j) {
+            colorMaps[i].data()[j].set(-1, -1);
+        }
+    });
 
     reset_c_map_used_net_to_one();
 
@@ -239,15 +261,41 @@ void Route_2pinnets::reallocate_two_pin_list() {
         return construct_2d_tree.NetDirtyBit[pin.net_id];
     }), v.end());
 
+    std::vector<int> dirty;
     for (uint32_t netId = 0; netId < rr_map.get_netNumber(); ++netId) {
         if (construct_2d_tree.NetDirtyBit[netId]) {
-            put_terminal_color_on_colormap(netId);
+            dirty.push_back(netId);
+        }
+    }
+    std::vector<Decomposition> results(dirty.size());
+    pool.parallel_for("2-pin decomposition", dirty.size(), [&](int i, int worker) {
+        int netId = dirty[i];
+        put_terminal_color_on_colormap(netId, colorMaps[worker]);
+
+        bfs_for_find_two_pin_list(rr_map.get_net(netId).get_pinList()[0].xy(), netId, colorMaps[worker], results[i]);
 
-            bfs_for_find_two_pin_list(rr_map.get_net(netId).get_pinList()[0].xy(), netId);
+        construct_2d_tree.NetDirtyBit[netId] = false;
+    });
 
-            construct_2d_tree.NetDirtyBit[netId] = false;
+    std::size_t size = v.size();
+    for (const Decomposition& result : results) {
+        size += result.two_pin_list.size();
+    }
+    v.reserve(size);
+    for (Decomposition& result : results) {
+        std::move(result.two_pin_list.begin(), result.two_pin_list.end(), std::back_inserter(v));
+    }
 
+    //the dangling paths of different nets may share edges
+    pool.parallel_for("dangling removal", dirty.size(), [&](int i, int) {
+        for (const std::vector<Coordinate_2d>& path : results[i].dangling) {
+            congestion.update_congestion_map_remove_two_pin_net<ConcurrentPolicy>(path, dirty[i]);
         }
+    });
+
+    //the 2-pin nets moved in the list
+    if (congestion.two_pins_indexed) {
+        congestion.index_two_pins(v);
     }
 
 }
@@ -96,6 +96,12 @@ struct Route_2pinnets {
         }
     };
 
+    //2-pin nets of a net, and the dangling paths of the net left to remove from the congestion map
+    struct Decomposition {
+        std::vector<Two_pin_element_2d> two_pin_list;
+        std::vector<std::vector<Coordinate_2d> > dangling;
+    };
+
     enum PointType {
         oneDegreeTerminal, severalDegreeTerminal, oneDegreeNonterminal, steinerPoint, twoDegree
     };
@@ -104,7 +110,7 @@ struct Route_2pinnets {
     boost::multi_array<Point_fc, 2> gridcell; //This is some kind of color map, for recording
     //which 2-pin net passed which gCell
 
-    boost::multi_array<ColorMap, 2> colorMap;
+    std::vector<boost::multi_array<ColorMap, 2> > colorMaps;  //one per worker of the thread pool
 
     int dirTransferTable[4] = { 1, 0, 3, 2 }; //FRONT <-> BACK, LEFT <-> RIGHT
     //Used by determine_is_terminal_or_steiner_point()
@@ -121,14 +127,15 @@ struct Route_2pinnets {
     void init_gridcell();
 
     void reset_c_map_used_net_to_one();
-    void put_terminal_color_on_colormap(int net_id);
-    Coordinate_2d determine_is_terminal_or_steiner_point(Coordinate_2d& c, Coordinate_2d& head, int net_id, PointType& pointType);
-    void bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net_id);
+    void put_terminal_color_on_colormap(int net_id, boost::multi_array<ColorMap, 2>& colorMap);
+    Coordinate_2d determine_is_terminal_or_steiner_point(Coordinate_2d& c, Coordinate_2d& head, int net_id, PointType& pointType,
+            const boost::multi_array<ColorMap, 2>& colorMap);
+    void bfs_for_find_two_pin_list(Coordinate_2d start_coor, int net_id, boost::multi_array<ColorMap, 2>& colorMap, Decomposition& result);
     void reallocate_two_pin_list();
 
 private:
-    void add_two_pin(int net_id, std::vector<Coordinate_2d>& path);
-    void fillTree(int offset, int net_id);
+    void add_two_pin(int net_id, std::vector<Coordinate_2d>& path, std::vector<Two_pin_element_2d>& two_pin_list);
+    void fillTree(const std::vector<Two_pin_element_2d>& two_pin_list, int net_id);
 
 };
 
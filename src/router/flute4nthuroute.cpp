@@ -1,33 +1,301 @@
 #include "flute4nthuroute.h"
 
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
 
 #include "../flute/flute-function.h"
 namespace NTHUR {
 
-Flute::Flute() {
-    readLUT();      //Read in the binary lookup table - POWVFILE, POSTFILE
+namespace {
 
+constexpr char magic[] = "NTHURFLC";
+constexpr int32_t version = 2;
+
+template<class T>
+void write(std::ofstream& ofs, const T& v) {
+    ofs.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template<class T>
+bool read(std::ifstream& ifs, T& v) {
+    return static_cast<bool>(ifs.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+/*
+ The tree flute() returns for 2 pins, or 3 distinct pins, written in place.
+ 2 pins are joined as given. 3 pins are joined to the Steiner point at their median x
+ and y, in the order of flute(): sorted by y, the ties broken as by its selection sorts.
+ return false for 3 pins with a duplicate, which flute() removes.
+ */
+bool low_degree_tree(const std::vector<Net::Pin>& pins, TreeFlute& result) {
+    const int d = pins.size();
+    result.deg = d;
+    result.number = 2 * d - 2;
+    result.branch.resize(2 * d - 2);
+    if (d == 2) {
+        result.length = std::abs(pins[0].x - pins[1].x) + std::abs(pins[0].y - pins[1].y);
+        for (int i = 0; i < 2; ++i) {
+            result.branch[i].x = pins[i].x;
+            result.branch[i].y = pins[i].y;
+            result.branch[i].n = 1;
+        }
+        return true;
+    }
+    if (pins[0].xy() == pins[1].xy() || pins[0].xy() == pins[2].xy() || pins[1].xy() == pins[2].xy()) {
+        return false;
+    }
+
+    // sort x
+    int p[3] = { 0, 1, 2 };
+    for (int i = 0; i < 2; ++i) {
+        int minidx = i;
+        for (int j = i + 1; j < 3; ++j) {
+            if (pins[p[minidx]].x > pins[p[j]].x) {
+                minidx = j;
+            }
+        }
+        std::swap(p[i], p[minidx]);
+    }
+    int xs[3];
+    int o[3];   // x rank of each pin
+    for (int i = 0; i < 3; ++i) {
+        xs[i] = pins[p[i]].x;
+        o[p[i]] = i;
+    }
+    // sort y, s[i] the x rank of the i-th pin by y
+    int ys[3];
+    int s[3];
+    for (int i = 0; i < 2; ++i) {
+        int minidx = i;
+        for (int j = i + 1; j < 3; ++j) {
+            if (pins[p[minidx]].y > pins[p[j]].y) {
+                minidx = j;
+            }
+        }
+        ys[i] = pins[p[minidx]].y;
+        s[i] = o[p[minidx]];
+        p[minidx] = p[i];
+    }
+    ys[2] = pins[p[2]].y;
+    s[2] = o[p[2]];
+
+    result.length = xs[2] - xs[0] + ys[2] - ys[0];
+    for (int i = 0; i < 3; ++i) {
+        result.branch[i].x = xs[s[i]];
+        result.branch[i].y = ys[i];
+        result.branch[i].n = 3;
+    }
+    result.branch[3].x = xs[1];
+    result.branch[3].y = ys[1];
+    result.branch[3].n = 3;
+    return true;
+}
+
+} // namespace
+
+int Flute::check_low_degree_trees(int nets, unsigned seed) {
+    std::mt19937 rng(seed);
+    int mismatches = 0;
+    for (int i = 0; i < nets; ++i) {
+        const int d = 2 + rng() % 2;
+        const int size = 1 + rng() % 4;
+        std::vector<Net::Pin> pins;
+        for (int pinId = 0; pinId < d; ++pinId) {
+            pins.emplace_back(rng() % size, rng() % size, 0);
+        }
+        TreeFlute result;
+        if (!low_degree_tree(pins, result)) {
+            continue;
+        }
+        DTYPE x[3];
+        DTYPE y[3];
+        for (int pinId = 0; pinId < d; ++pinId) {
+            x[pinId] = pins[pinId].x;
+            y[pinId] = pins[pinId].y;
+        }
+        std::vector<Branch> branch(2 * d - 2);
+        Tree tree = flute(d, x, y, ACCURACY, branch.data());
+        bool same = tree.deg == result.deg && tree.length == result.length;
+        for (int b = 0; same && b < 2 * tree.deg - 2; ++b) {
+            same = branch[b].x == result.branch[b].x && branch[b].y == result.branch[b].y && branch[b].n == result.branch[b].n;
+        }
+        if (!same) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+std::size_t Flute::PatternHash::operator()(const Pattern& p) const {
+    return boost::hash_range(p.begin(), p.end());
+}
+
+Flute::Flute(const std::string& cacheFile) :
+        cacheFile { cacheFile }, //
+        direct { 0 }, //
+        hits { 0 }, //
+        misses { 0 }, //
+        loaded { 0 } {
+    readLUT();      //Read in the binary lookup table - POWVFILE, POSTFILE, by the first Flute of the process
+    if (!cacheFile.empty()) {
+        load_cache();
+    }
 }
 
-void Flute::routeNet(const std::vector<Net::Pin>& pinList, TreeFlute& result) {
+void Flute::routeNet(const std::vector<Net::Pin>& pinList, TreeFlute& result) const {
     int pinNumber = pinList.size();
 
     //The pin number must <= MAXD, or the flute will crash
     assert(pinNumber <= MAXD);
 
-    // insert 2D-coordinate of pins of a net into x_ and y_
+    //the trees of the low degree nets are cheaper to build than to look up
+    if (pinNumber <= 3 && low_degree_tree(pinList, result)) {
+        ++direct;
+        return;
+    }
+
+    int minX = pinList[0].x;
+    int minY = pinList[0].y;
+    for (const Net::Pin& pin : pinList) {
+        minX = std::min(minX, pin.x);
+        minY = std::min(minY, pin.y);
+    }
+    Pattern pattern(2 * pinNumber);
     for (int pinId = 0; pinId < pinNumber; ++pinId) {
-        x_[pinId] = pinList[pinId].x ;
-        y_[pinId] = pinList[pinId].y ;
+        pattern[2 * pinId] = pinList[pinId].x - minX;
+        pattern[2 * pinId + 1] = pinList[pinId].y - minY;
+    }
+
+    Shard& s = shard(pattern);
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.trees.find(pattern);
+        if (it != s.trees.end()) {
+            result = it->second;
+            found = true;
+        }
     }
+    if (found) {
+        ++hits;
+    } else {
+        ++misses;
+        std::array<DTYPE, MAXD> x;             // temporal integer array used by flute
+        std::array<DTYPE, MAXD> y;             // temporal integer array used by flute
 
-    // obtain the routing tree by FLUTE
-    TreeWrapper routingTree;
+        // insert 2D-coordinate of the translated pins of a net into x and y
+        for (int pinId = 0; pinId < pinNumber; ++pinId) {
+            x[pinId] = pattern[2 * pinId];
+            y[pinId] = pattern[2 * pinId + 1];
+        }
 
-    routingTree.tree = flute(pinNumber, x_.data(), y_.data(), ACCURACY);
-    result.set(routingTree.tree);
+        // obtain the routing tree by FLUTE, written in place; duplicate pins make it smaller
+        result.branch.resize(2 * pinNumber - 2);
+        Tree tree = flute(pinNumber, x.data(), y.data(), ACCURACY, result.branch.data());
+        result.deg = tree.deg;
+        result.length = tree.length;
+        result.number = 2 * tree.deg - 2;
+        result.branch.resize(result.number);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.trees.emplace(std::move(pattern), result);
+    }
+
+    // translate the tree back to the pins
+    for (Branch& b : result.branch) {
+        b.x += minX;
+        b.y += minY;
+    }
+}
 
+//The file holds the FLUTE accuracy the trees depend on, then the patterns and their trees,
+//the lengths as double and the coordinates as int32 whatever DTYPE is
+void Flute::load_cache() {
+    std::ifstream ifs(cacheFile, std::ifstream::in | std::ifstream::binary);
+    char header[sizeof(magic) - 1];
+    int32_t v, accuracy;
+    if (!ifs.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(header)) != 0 || !read(ifs, v) || v != version || !read(ifs, accuracy)
+            || accuracy != ACCURACY) {
+        return;
+    }
+    int32_t size;
+    while (read(ifs, size) && size > 0 && size <= 2 * MAXD) {
+        Pattern pattern(size);
+        TreeFlute tree;
+        int32_t deg, number, branches;
+        double length;
+        bool good = ifs.read(reinterpret_cast<char*>(pattern.data()), size * sizeof(int32_t)) && read(ifs, deg) && read(ifs, length) && read(ifs, number)
+                && read(ifs, branches) && branches >= 0 && branches <= 2 * MAXD;
+        if (!good) {
+            break;
+        }
+        tree.deg = deg;
+        tree.length = length;
+        tree.number = number;
+        tree.branch.resize(branches);
+        for (Branch& b : tree.branch) {
+            int32_t x, y, n;
+            good = good && read(ifs, x) && read(ifs, y) && read(ifs, n);
+            b.x = x;
+            b.y = y;
+            b.n = n;
+        }
+        if (!good) {
+            break;
+        }
+        shard(pattern).trees.emplace(std::move(pattern), std::move(tree));
+        ++loaded;
+    }
+}
+
+void Flute::save_cache() const {
+    if (cacheFile.empty() || misses == 0) {
+        return;
+    }
+    std::string tmp = cacheFile + ".tmp";
+    std::ofstream ofs(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    ofs.write(magic, sizeof(magic) - 1);
+    write(ofs, version);
+    write<int32_t>(ofs, ACCURACY);
+    for (const Shard& s : shards) {
+        for (const auto& entry : s.trees) {
+            const TreeFlute& tree = entry.second;
+            write<int32_t>(ofs, entry.first.size());
+            ofs.write(reinterpret_cast<const char*>(entry.first.data()), entry.first.size() * sizeof(int32_t));
+            write<int32_t>(ofs, tree.deg);
+            write<double>(ofs, tree.length);
+            write<int32_t>(ofs, tree.number);
+            write<int32_t>(ofs, tree.branch.size());
+            for (const Branch& b : tree.branch) {
+                write<int32_t>(ofs, b.x);
+                write<int32_t>(ofs, b.y);
+                write<int32_t>(ofs, b.n);
+            }
+        }
+    }
+    ofs.close();
+    if (ofs) {
+        std::rename(tmp.c_str(), cacheFile.c_str());
+    }
+}
+
+std::string Flute::cacheStatistics() const {
+    std::size_t trees = 0;
+    for (const Shard& s : shards) {
+        trees += s.trees.size();
+    }
+    long nets = hits + misses;
+    char buffer[200];
+    std::snprintf(buffer, sizeof(buffer), "FLUTE cache: %ld nets, %ld hits (%.1f%%), %zu trees, %ld read from file; %ld nets of 2 or 3 pins built directly", nets,
+            hits.load(), nets > 0 ? 100. * hits / nets : 0., trees, loaded, direct.load());
+    return buffer;
 }
 
 void Flute::printTree(Tree& routingTree) {
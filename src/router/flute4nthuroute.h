@@ -2,6 +2,10 @@
 #define INC_FLUTE_4_NTHUROUTE_H
 
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "../grdb/RoutingComponent.h"
@@ -38,33 +42,59 @@ struct TreeFlute {
     }
 };
 
-struct TreeWrapper {
-
-    Tree tree;
-
-    TreeWrapper() {
-        tree.branch = nullptr;
-    }
-    ~TreeWrapper() {
-        if (tree.branch != nullptr) {
-            free(tree.branch);
-        }
-    }
-};
-
+///@brief FLUTE trees of the nets, cached by pin pattern.
+///@details The pattern of a net is the list of its pins translated so that the lowest x and y are 0.
+///         Nets with the same pattern get the same tree, translated back to their pins. The pins
+///         are kept in order rather than sorted: FLUTE breaks the ties by the pin order, so that
+///         a cached tree is always the one FLUTE would return. The cache can be read from and
+///         saved to a file, to be shared by the runs.
+///         The nets of 2 or 3 pins are not cached: their tree is built in place, as FLUTE builds it.
 class Flute {
 public:
-    Flute();
+    ///@param cacheFile trees of the previous runs, read if it exists and saved by save_cache(); none if empty
+    explicit Flute(const std::string& cacheFile = "");
 
-    void routeNet(const std::vector<Net::Pin>& pinList, TreeFlute& result);
+    ///@brief Thread safe: the lookup table is shared and only read, FLUTE works on the stack of the call,
+    ///       and the cache is locked by shard
+    void routeNet(const std::vector<Net::Pin>& pinList, TreeFlute& result) const;
+    ///@brief Save the cache to its file, if trees were added to it
+    void save_cache() const;
+    ///@brief Hits, misses and size of the cache
+    std::string cacheStatistics() const;
+    ///@brief Build the trees of random nets of 2 or 3 pins both in place and by FLUTE
+    ///@details The pins are drawn on grids of at most 4x4 GCells, so that they share their x, their y or
+    ///         both. The nets of 3 pins with a duplicate are left to FLUTE by routeNet(), they are skipped.
+    ///@return the number of nets whose trees differ
+    static int check_low_degree_trees(int nets, unsigned seed);
 
     void printTree(Tree& routingTree);
     void plotTree(Tree& routingTree);
     int treeWireLength(Tree& routingTree);
 
 private:
-    std::array<DTYPE, MAXD> x_;             ///< temporal integer array used by flute
-    std::array<DTYPE, MAXD> y_;             ///< temporal integer array used by flute
+    typedef std::vector<int> Pattern;  //x0, y0, x1, y1... of the translated pins
+
+    struct PatternHash {
+        std::size_t operator()(const Pattern& p) const;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Pattern, TreeFlute, PatternHash> trees;
+    };
+    static constexpr int SHARDS = 16;
+
+    std::string cacheFile;
+    mutable std::array<Shard, SHARDS> shards;
+    mutable std::atomic<long> direct;  //trees built in place
+    mutable std::atomic<long> hits;
+    mutable std::atomic<long> misses;
+    long loaded;        //trees read from cacheFile
+
+    Shard& shard(const Pattern& pattern) const {
+        return shards[PatternHash()(pattern) % SHARDS];
+    }
+    void load_cache();
 };
 } // namespace NTHUR
 #endif //INC_FLUTE_4_NTHUROUTE_H
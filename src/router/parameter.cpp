@@ -1,6 +1,7 @@
 #include "parameter.h"
 
 #include <getopt.h>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 
@@ -11,6 +12,7 @@
 #include "../spdlog/details/spdlog_impl.h"
 #include "../spdlog/logger.h"
 #include "DataDef.h"
+#include "MonotonicRouting.h"
 
 namespace NTHUR {
 
@@ -123,7 +125,11 @@ void ParameterAnalyzer::analyze2() {
     int long_option_index = 0;
     struct option long_option[] = { { "p2-max-iteration", 1, 0, 1 }, { "p3-max-iteration", 1, 0, 2 }, { "overflow-threshold", 1, 0, 3 }, { "p3-init-box-size", 1, 0, 4 }, { "p3-box-expand-size", 1, 0,
             5 }, { "p2-boxsize-inc", 1, 0, 6 }, { "p2-box-expand-size", 1, 0, 7 }, { "monotonic-routing", 1, 0, 8 }, { "simple", 0, 0, 9 }, { "input", 1, 0, 'i' }, { "output", 1, 0, 'o' }, {
-            "p2-init-box-size", 1, 0, 6 }, { 0, 0, 0, 0 } };
+            "p2-init-box-size", 1, 0, 6 }, { "coarse-tile-size", 1, 0, 10 }, { "coarse-min-span", 1, 0, 11 }, {
+            "threads", 1, 0, 12 }, { "reroute-batch", 1, 0, 13 }, { "deterministic", 0, 0, 14 }, { "p1-batch", 1, 0, 15 }, { "p2-stall-rate", 1, 0, 16 }, {
+            "p2-stall-window", 1, 0, 17 }, { "p2-stall-escalations", 1, 0, 18 }, { "time-limit", 1, 0, 19 }, { "checkpoint", 1, 0, 20 }, {
+            "checkpoint-interval", 1, 0, 21 }, { "resume", 1, 0, 22 }, { "eco", 1, 0, 23 }, { "flute-cache", 1, 0, 24 }, {
+            "wavefront-max-cells", 1, 0, 25 }, { "check-flute", 1, 0, 26 }, { 0, 0, 0, 0 } };
     while ((cmd = getopt_long(argc, argv, "i:I:o:p:", long_option, &long_option_index)) != -1) {
         string parameter;
         bool enable;
@@ -180,6 +186,75 @@ void ParameterAnalyzer::analyze2() {
             cout << "Simple Mode enable - Routing Parameter Auto Fitting!" << endl;
             routingParam.set_simple_mode_en(true);
             break;
+        case 10:
+            cout << "Coarse maze routing tile size set to " << parameter << endl;
+            routingParam.set_coarse_tile_size(atoi(parameter.c_str()));
+            break;
+        case 11:
+            cout << "Coarse maze routing min window span set to " << parameter << endl;
+            routingParam.set_coarse_min_span(atoi(parameter.c_str()));
+            break;
+        case 12:
+            cout << "Threads set to " << parameter << endl;
+            routingParam.set_threads(atoi(parameter.c_str()));
+            break;
+        case 13:
+            cout << "Optimistic rip-up and reroute batch size set to " << parameter << endl;
+            routingParam.set_reroute_batch(atoi(parameter.c_str()));
+            break;
+        case 14:
+            cout << "Deterministic optimistic rip-up and reroute enable!" << endl;
+            routingParam.set_deterministic(true);
+            break;
+        case 15:
+            cout << "Initial routing edge shifting batch size set to " << parameter << endl;
+            routingParam.set_p1_batch(atoi(parameter.c_str()));
+            break;
+        case 16:
+            cout << "P2 stall overflow reduction per second set to " << parameter << endl;
+            routingParam.set_stall_rate_p2(atof(parameter.c_str()));
+            break;
+        case 17:
+            cout << "P2 stall window set to " << parameter << endl;
+            routingParam.set_stall_window_p2(atoi(parameter.c_str()));
+            break;
+        case 18:
+            cout << "P2 stall box expansion escalations set to " << parameter << endl;
+            routingParam.set_stall_escalations_p2(atoi(parameter.c_str()));
+            break;
+        case 19:
+            cout << "Time limit set to " << parameter << " seconds" << endl;
+            routingParam.set_deadline(std::chrono::steady_clock::now() + //
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(atof(parameter.c_str()))));
+            break;
+        case 20:
+            cout << "Checkpoint file set to " << parameter << endl;
+            routingParam.set_checkpoint_file(parameter);
+            break;
+        case 21:
+            cout << "Checkpoint interval set to " << parameter << endl;
+            routingParam.set_checkpoint_interval(atoi(parameter.c_str()));
+            break;
+        case 22:
+            cout << "Resume from " << parameter << endl;
+            routingParam.set_resume_file(parameter);
+            break;
+        case 23:
+            cout << "ECO from " << parameter << endl;
+            routingParam.set_eco_file(parameter);
+            break;
+        case 24:
+            cout << "FLUTE cache file set to " << parameter << endl;
+            routingParam.set_flute_cache_file(parameter);
+            break;
+        case 25:
+            cout << "Monotonic routing wavefront max cells set to " << parameter << endl;
+            routingParam.set_wavefront_max_cells(atoi(parameter.c_str()));
+            break;
+        case 26:
+            cout << "FLUTE check nets set to " << parameter << endl;
+            routingParam.set_flute_check_nets(atoi(parameter.c_str()));
+            break;
         case 'i':
             cout << "Input file " << parameter << endl;
             this->inputFileName.append(parameter);
@@ -398,11 +473,36 @@ RoutingParameters::RoutingParameters() {
     init_box_size_p2 = 10;
     box_size_inc_p2 = 10;
     overflow_threshold = 200;
+    stall_rate_p2 = 0;
+    stall_window_p2 = 5;
+    stall_escalations_p2 = 3;
 
     /* Part 3 Setting */
     iteration_p3 = 20;
     init_box_size_p3 = 10;
     box_size_inc_p3 = 15;
+
+    /* Coarse Maze Routing Setting */
+    coarse_tile_size = 0;
+    coarse_min_span = 100;
+
+    /* Parallel Setting */
+    threads = 1;
+    reroute_batch = 0;
+    deterministic = false;
+    p1_batch = 0;
+
+    /* Time Budget Setting */
+    deadline = std::chrono::steady_clock::time_point::max();
+
+    /* Checkpoint Setting */
+    checkpoint_interval = 10;
+
+    /* FLUTE Setting */
+    flute_check_nets = 0;
+
+    /* Monotonic Routing Setting */
+    wavefront_max_cells = WAVEFRONT_MAX_CELLS;
     BOXSIZE_INC = 10;
 }
 
@@ -1,6 +1,7 @@
 #ifndef INC_PARAMETER_H
 #define INC_PARAMETER_H
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -108,11 +109,29 @@ public:
     void set_init_box_size_p2(int size);
     void set_box_size_inc_p2(int inc);
     void set_overflow_threshold(int th);
+    void set_stall_rate_p2(double rate);
+    void set_stall_window_p2(int window);
+    void set_stall_escalations_p2(int escalations);
 
     void set_iteration_p3(int it);
     void set_init_box_size_p3(int size);
     void set_box_size_inc_p3(int inc);
 
+    void set_coarse_tile_size(int size);
+    void set_coarse_min_span(int span);
+    void set_threads(int threads);
+    void set_reroute_batch(int batch);
+    void set_deterministic(bool en);
+    void set_p1_batch(int batch);
+    void set_deadline(std::chrono::steady_clock::time_point deadline);
+    void set_checkpoint_file(const std::string& file);
+    void set_checkpoint_interval(int interval);
+    void set_resume_file(const std::string& file);
+    void set_eco_file(const std::string& file);
+    void set_flute_cache_file(const std::string& file);
+    void set_flute_check_nets(int nets);
+    void set_wavefront_max_cells(int cells);
+
     /* Fetching Parameter */
     bool get_monotonic_en() const;
     bool get_simple_mode_en() const;
@@ -120,11 +139,29 @@ public:
     int get_init_box_size_p2() const;
     int get_box_size_inc_p2() const;
     int get_overflow_threshold() const;
+    double get_stall_rate_p2() const;
+    int get_stall_window_p2() const;
+    int get_stall_escalations_p2() const;
 
     int get_iteration_p3() const;
     int get_init_box_size_p3() const;
     int get_box_size_inc_p3() const;
 
+    int get_coarse_tile_size() const;
+    int get_coarse_min_span() const;
+    int get_threads() const;
+    int get_reroute_batch() const;
+    bool get_deterministic() const;
+    int get_p1_batch() const;
+    std::chrono::steady_clock::time_point get_deadline() const;
+    const std::string& get_checkpoint_file() const;
+    int get_checkpoint_interval() const;
+    const std::string& get_resume_file() const;
+    const std::string& get_eco_file() const;
+    const std::string& get_flute_cache_file() const;
+    int get_flute_check_nets() const;
+    int get_wavefront_max_cells() const;
+
 private:
     /* Common Setting */
     bool monotonic_routing_en;
@@ -135,11 +172,42 @@ private:
     int init_box_size_p2;
     int box_size_inc_p2;
     int overflow_threshold;
+    double stall_rate_p2;       //overflow reduction per second below which the iterations stall, 0: no adaptive control
+    int stall_window_p2;        //iterations the overflow reduction is measured over
+    int stall_escalations_p2;   //box expansion doublings before handing over to the post processing
 
     /* Part 3 Setting */
     int iteration_p3;
     int init_box_size_p3;
     int box_size_inc_p3;
+
+    /* Coarse Maze Routing Setting */
+    int coarse_tile_size;   //0: disabled
+    int coarse_min_span;
+
+    /* Parallel Setting */
+    int threads;            //workers of the thread pool shared by all the stages
+    int reroute_batch;      //2-pin nets per optimistic batch, 0: window partitioning
+    bool deterministic;     //optimistic batches independent of the thread count
+    int p1_batch;           //nets edge shifted concurrently in the initial routing, 0: serial
+
+    /* Time Budget Setting */
+    std::chrono::steady_clock::time_point deadline;    //end of the rip-up and reroute, time_point::max(): none
+
+    /* Checkpoint Setting */
+    std::string checkpoint_file;    //empty: no checkpoint
+    int checkpoint_interval;        //iterations between two checkpoints
+    std::string resume_file;        //checkpoint to resume from, empty: route from scratch
+
+    /* ECO Setting */
+    std::string eco_file;           //previous routing kept by the unchanged nets, empty: route every net
+
+    /* FLUTE Setting */
+    std::string flute_cache_file;   //FLUTE trees shared by the runs, empty: cached within the run only
+    int flute_check_nets;           //random nets whose in place trees are checked against FLUTE, 0: no check
+
+    /* Monotonic Routing Setting */
+    int wavefront_max_cells;        //largest bounding box of the wavefront kernel, 0: scalar only
 public:
     int BOXSIZE_INC;
 };
@@ -187,6 +255,21 @@ void RoutingParameters::set_overflow_threshold(int th) {
     overflow_threshold = th;
 }
 
+inline
+void RoutingParameters::set_stall_rate_p2(double rate) {
+    stall_rate_p2 = rate;
+}
+
+inline
+void RoutingParameters::set_stall_window_p2(int window) {
+    stall_window_p2 = window;
+}
+
+inline
+void RoutingParameters::set_stall_escalations_p2(int escalations) {
+    stall_escalations_p2 = escalations;
+}
+
 inline
 void RoutingParameters::set_iteration_p3(int it) {
     iteration_p3 = it;
@@ -202,6 +285,76 @@ void RoutingParameters::set_box_size_inc_p3(int inc) {
     box_size_inc_p3 = inc;
 }
 
+inline
+void RoutingParameters::set_coarse_tile_size(int size) {
+    coarse_tile_size = size;
+}
+
+inline
+void RoutingParameters::set_coarse_min_span(int span) {
+    coarse_min_span = span;
+}
+
+inline
+void RoutingParameters::set_threads(int threads) {
+    this->threads = threads;
+}
+
+inline
+void RoutingParameters::set_reroute_batch(int batch) {
+    reroute_batch = batch;
+}
+
+inline
+void RoutingParameters::set_deterministic(bool en) {
+    deterministic = en;
+}
+
+inline
+void RoutingParameters::set_p1_batch(int batch) {
+    p1_batch = batch;
+}
+
+inline
+void RoutingParameters::set_deadline(std::chrono::steady_clock::time_point deadline) {
+    this->deadline = deadline;
+}
+
+inline
+void RoutingParameters::set_checkpoint_file(const std::string& file) {
+    checkpoint_file = file;
+}
+
+inline
+void RoutingParameters::set_checkpoint_interval(int interval) {
+    checkpoint_interval = interval;
+}
+
+inline
+void RoutingParameters::set_resume_file(const std::string& file) {
+    resume_file = file;
+}
+
+inline
+void RoutingParameters::set_eco_file(const std::string& file) {
+    eco_file = file;
+}
+
+inline
+void RoutingParameters::set_flute_cache_file(const std::string& file) {
+    flute_cache_file = file;
+}
+
+inline
+void RoutingParameters::set_flute_check_nets(int nets) {
+    flute_check_nets = nets;
+}
+
+inline
+void RoutingParameters::set_wavefront_max_cells(int cells) {
+    wavefront_max_cells = cells;
+}
+
 /* Fetching Parameter */
 inline
 bool RoutingParameters::get_monotonic_en() const {
@@ -233,6 +386,21 @@ int RoutingParameters::get_overflow_threshold() const {
     return this->overflow_threshold;
 }
 
+inline
+double RoutingParameters::get_stall_rate_p2() const {
+    return this->stall_rate_p2;
+}
+
+inline
+int RoutingParameters::get_stall_window_p2() const {
+    return this->stall_window_p2;
+}
+
+inline
+int RoutingParameters::get_stall_escalations_p2() const {
+    return this->stall_escalations_p2;
+}
+
 inline
 int RoutingParameters::get_iteration_p3() const {
     return this->iteration_p3;
@@ -247,6 +415,76 @@ inline
 int RoutingParameters::get_box_size_inc_p3() const {
     return this->box_size_inc_p3;
 }
+
+inline
+int RoutingParameters::get_coarse_tile_size() const {
+    return this->coarse_tile_size;
+}
+
+inline
+int RoutingParameters::get_coarse_min_span() const {
+    return this->coarse_min_span;
+}
+
+inline
+int RoutingParameters::get_threads() const {
+    return this->threads;
+}
+
+inline
+int RoutingParameters::get_reroute_batch() const {
+    return this->reroute_batch;
+}
+
+inline
+bool RoutingParameters::get_deterministic() const {
+    return this->deterministic;
+}
+
+inline
+int RoutingParameters::get_p1_batch() const {
+    return this->p1_batch;
+}
+
+inline
+std::chrono::steady_clock::time_point RoutingParameters::get_deadline() const {
+    return this->deadline;
+}
+
+inline
+const std::string& RoutingParameters::get_checkpoint_file() const {
+    return this->checkpoint_file;
+}
+
+inline
+int RoutingParameters::get_checkpoint_interval() const {
+    return this->checkpoint_interval;
+}
+
+inline
+const std::string& RoutingParameters::get_resume_file() const {
+    return this->resume_file;
+}
+
+inline
+const std::string& RoutingParameters::get_eco_file() const {
+    return this->eco_file;
+}
+
+inline
+const std::string& RoutingParameters::get_flute_cache_file() const {
+    return this->flute_cache_file;
+}
+
+inline
+int RoutingParameters::get_flute_check_nets() const {
+    return this->flute_check_nets;
+}
+
+inline
+int RoutingParameters::get_wavefront_max_cells() const {
+    return this->wavefront_max_cells;
+}
 //}}}
 /* TroyLee: RouterParameter Fetch From Command-line */
 